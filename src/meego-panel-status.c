@@ -44,6 +44,7 @@
 
 #include "mps-view-bridge.h"
 #include "mps-feed-switcher.h"
+#include "mps-governor.h"
 
 typedef struct _MeegoStatusPanel
 {
@@ -122,6 +123,20 @@ on_client_set_size (MplPanelClient *client,
   clutter_actor_set_size (table, width, height);
 }
 
+static void
+_panel_show_begin_cb (MplPanelClient *client,
+                      gpointer        userdata)
+{
+  mps_governor_set_visible (TRUE);
+}
+
+static void
+_panel_hide_end_cb (MplPanelClient *client,
+                    gpointer        userdata)
+{
+  mps_governor_set_visible (FALSE);
+}
+
 static void
 setup_standalone (MeegoStatusPanel *status_panel)
 {
@@ -166,6 +181,15 @@ setup_panel (MeegoStatusPanel *status_panel)
   g_signal_connect (panel,
                     "set-size", G_CALLBACK (on_client_set_size),
                     status);
+
+  /* Start hidden, nothing is on screen until the toolbar shows us */
+  mps_governor_set_visible (FALSE);
+  g_signal_connect (panel,
+                    "show-begin", G_CALLBACK (_panel_show_begin_cb),
+                    NULL);
+  g_signal_connect (panel,
+                    "hide-end", G_CALLBACK (_panel_hide_end_cb),
+                    NULL);
 }
 
 static gboolean status_standalone = FALSE;
@@ -187,6 +211,10 @@ main (int argc, char *argv[])
   GOptionContext *context;
   GError *error = NULL;
 
+  /* Avatars are decoded in worker threads */
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
   setlocale (LC_ALL, "");
   bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
   bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "mps-avatar-cache.h"
+
+#define CACHE_BUDGET (4 * 1024 * 1024) /* bytes of texture data */
+
+/* Each atlas page is a grid of cells. A texel of padding on every side
+ * keeps neighbours from bleeding in when filtering.
+ */
+#define ATLAS_SIZE 512
+#define CELL_SIZE 64
+#define CELL_PADDING 1
+#define CELLS_PER_ROW (ATLAS_SIZE / CELL_SIZE)
+#define CELLS_PER_PAGE (CELLS_PER_ROW * CELLS_PER_ROW)
+
+typedef struct
+{
+  CoglHandle texture;
+  guint64 used_cells;
+  guint n_used;
+} MpsAvatarAtlasPage;
+
+typedef struct
+{
+  gchar *path;
+  MpsAvatarImage image;
+  gsize size;
+
+  /* NULL if the avatar was too big for a cell and has its own texture */
+  MpsAvatarAtlasPage *page;
+  guint cell;
+
+  guint users;
+  GList *lru_link; /* only while unused */
+} MpsAvatarCacheEntry;
+
+static GHashTable *entries = NULL;
+static GQueue *unused = NULL; /* most recently used at the head */
+static GList *pages = NULL;
+static gsize total_size = 0;
+
+static void
+_release_cell (MpsAvatarAtlasPage *page,
+               guint               cell)
+{
+  page->used_cells &= ~(G_GUINT64_CONSTANT (1) << cell);
+  page->n_used--;
+
+  if (page->n_used == 0)
+  {
+    pages = g_list_remove (pages, page);
+    cogl_handle_unref (page->texture);
+    g_slice_free (MpsAvatarAtlasPage, page);
+  }
+}
+
+static void
+_entry_free (MpsAvatarCacheEntry *entry)
+{
+  if (entry->page)
+    _release_cell (entry->page, entry->cell);
+  else
+    cogl_handle_unref (entry->image.texture);
+
+  g_free (entry->path);
+  g_slice_free (MpsAvatarCacheEntry, entry);
+}
+
+static gboolean
+_allocate_cell (MpsAvatarAtlasPage **page_out,
+                guint               *cell_out)
+{
+  MpsAvatarAtlasPage *page;
+  CoglHandle texture;
+  guint8 *blank;
+  GList *l;
+  guint cell;
+
+  for (l = pages; l; l = l->next)
+  {
+    page = (MpsAvatarAtlasPage *)l->data;
+
+    if (page->n_used == CELLS_PER_PAGE)
+      continue;
+
+    for (cell = 0; cell < CELLS_PER_PAGE; cell++)
+    {
+      if (!(page->used_cells & (G_GUINT64_CONSTANT (1) << cell)))
+        break;
+    }
+
+    page->used_cells |= G_GUINT64_CONSTANT (1) << cell;
+    page->n_used++;
+
+    *page_out = page;
+    *cell_out = cell;
+    return TRUE;
+  }
+
+  texture = cogl_texture_new_with_size (ATLAS_SIZE,
+                                        ATLAS_SIZE,
+                                        COGL_TEXTURE_NO_AUTO_MIPMAP,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+  if (texture == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  /* The padding gets sampled at the edges so it has to be defined */
+  blank = g_malloc0 (ATLAS_SIZE * ATLAS_SIZE * 4);
+  cogl_texture_set_region (texture,
+                           0, 0,
+                           0, 0,
+                           ATLAS_SIZE, ATLAS_SIZE,
+                           ATLAS_SIZE, ATLAS_SIZE,
+                           COGL_PIXEL_FORMAT_RGBA_8888,
+                           ATLAS_SIZE * 4,
+                           blank);
+  g_free (blank);
+
+  page = g_slice_new0 (MpsAvatarAtlasPage);
+  page->texture = texture;
+  page->used_cells = 1;
+  page->n_used = 1;
+  pages = g_list_append (pages, page);
+
+  *page_out = page;
+  *cell_out = 0;
+  return TRUE;
+}
+
+static void
+_ensure_cache (void)
+{
+  if (entries)
+    return;
+
+  entries = g_hash_table_new_full (g_str_hash,
+                                   g_str_equal,
+                                   NULL,
+                                   (GDestroyNotify)_entry_free);
+  unused = g_queue_new ();
+}
+
+static void
+_evict (void)
+{
+  MpsAvatarCacheEntry *entry;
+
+  /* Textures still on screen can't be freed anyway */
+  while (total_size > CACHE_BUDGET &&
+         (entry = g_queue_pop_tail (unused)))
+  {
+    entry->lru_link = NULL;
+    total_size -= entry->size;
+    g_hash_table_remove (entries, entry->path);
+  }
+}
+
+static void
+_use_entry (MpsAvatarCacheEntry *entry)
+{
+  if (entry->lru_link)
+  {
+    g_queue_delete_link (unused, entry->lru_link);
+    entry->lru_link = NULL;
+  }
+
+  entry->users++;
+}
+
+gboolean
+mps_avatar_cache_get (const gchar    *path,
+                      MpsAvatarImage *image)
+{
+  MpsAvatarCacheEntry *entry;
+
+  _ensure_cache ();
+
+  entry = g_hash_table_lookup (entries, path);
+
+  if (!entry)
+    return FALSE;
+
+  _use_entry (entry);
+  *image = entry->image;
+
+  return TRUE;
+}
+
+gboolean
+mps_avatar_cache_add (const gchar    *path,
+                      GdkPixbuf      *pixbuf,
+                      MpsAvatarImage *image)
+{
+  MpsAvatarCacheEntry *entry;
+  MpsAvatarAtlasPage *page = NULL;
+  CoglPixelFormat format;
+  guint cell = 0;
+  gint width, height;
+
+  _ensure_cache ();
+
+  /* Someone else got there first */
+  if (mps_avatar_cache_get (path, image))
+    return TRUE;
+
+  format = gdk_pixbuf_get_has_alpha (pixbuf) ?
+    COGL_PIXEL_FORMAT_RGBA_8888 : COGL_PIXEL_FORMAT_RGB_888;
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  entry = g_slice_new0 (MpsAvatarCacheEntry);
+
+  if (width <= CELL_SIZE - 2 * CELL_PADDING &&
+      height <= CELL_SIZE - 2 * CELL_PADDING &&
+      _allocate_cell (&page, &cell))
+  {
+    entry->page = page;
+    entry->cell = cell;
+    entry->image.texture = page->texture;
+    entry->image.x = (cell % CELLS_PER_ROW) * CELL_SIZE + CELL_PADDING;
+    entry->image.y = (cell / CELLS_PER_ROW) * CELL_SIZE + CELL_PADDING;
+    entry->size = CELL_SIZE * CELL_SIZE * 4;
+
+    cogl_texture_set_region (page->texture,
+                             0, 0,
+                             entry->image.x, entry->image.y,
+                             width, height,
+                             width, height,
+                             format,
+                             gdk_pixbuf_get_rowstride (pixbuf),
+                             gdk_pixbuf_get_pixels (pixbuf));
+  } else {
+    entry->image.texture =
+      cogl_texture_new_from_data (width,
+                                  height,
+                                  COGL_TEXTURE_NONE,
+                                  format,
+                                  COGL_PIXEL_FORMAT_ANY,
+                                  gdk_pixbuf_get_rowstride (pixbuf),
+                                  gdk_pixbuf_get_pixels (pixbuf));
+
+    if (entry->image.texture == COGL_INVALID_HANDLE)
+    {
+      g_warning (G_STRLOC ": Unable to create texture for %s", path);
+      g_slice_free (MpsAvatarCacheEntry, entry);
+      return FALSE;
+    }
+
+    entry->size = width * height * 4;
+  }
+
+  entry->path = g_strdup (path);
+  entry->image.width = width;
+  entry->image.height = height;
+  entry->users = 1;
+
+  g_hash_table_insert (entries, entry->path, entry);
+  total_size += entry->size;
+
+  *image = entry->image;
+
+  _evict ();
+
+  return TRUE;
+}
+
+void
+mps_avatar_cache_release (const gchar *path)
+{
+  MpsAvatarCacheEntry *entry;
+
+  _ensure_cache ();
+
+  entry = g_hash_table_lookup (entries, path);
+
+  g_return_if_fail (entry && entry->users > 0);
+
+  entry->users--;
+
+  if (entry->users == 0)
+  {
+    g_queue_push_head (unused, entry);
+    entry->lru_link = unused->head;
+
+    _evict ();
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_AVATAR_CACHE
+#define _MPS_AVATAR_CACHE
+
+#include <glib.h>
+#include <cogl/cogl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* Process-wide avatar textures keyed by file path. Every user of a path
+ * shares one texture. Small avatars are packed into shared atlas textures so
+ * a screenful of them can be drawn in one batch. Textures nobody is using
+ * stay around until the cache goes over its byte budget, then the least
+ * recently used are dropped.
+ *
+ * Both getters mark the entry as in use, balance them with
+ * mps_avatar_cache_release. The texture in the image is not reffed.
+ */
+typedef struct
+{
+  CoglHandle texture;
+
+  /* Where in the texture the avatar is */
+  gint x;
+  gint y;
+  gint width;
+  gint height;
+} MpsAvatarImage;
+
+gboolean mps_avatar_cache_get (const gchar    *path,
+                               MpsAvatarImage *image);
+gboolean mps_avatar_cache_add (const gchar    *path,
+                               GdkPixbuf      *pixbuf,
+                               MpsAvatarImage *image);
+void mps_avatar_cache_release (const gchar *path);
+
+G_END_DECLS
+
+#endif /* _MPS_AVATAR_CACHE */
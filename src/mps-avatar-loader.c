@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "mps-avatar-loader.h"
+#include "mps-avatar-pack.h"
+
+/* Requests belong to the loader. They stay valid until their func has been
+ * called or they have been cancelled, after which they must not be touched.
+ */
+struct _MpsAvatarRequest {
+  volatile gint cancelled;
+
+  gchar *path;
+  gint size;
+  GdkPixbuf *pixbuf;
+  GError *error;
+
+  MpsAvatarLoadedFunc func;
+  gpointer userdata;
+};
+
+#define MAX_THREADS 2
+
+static GThreadPool *decode_pool = NULL;
+
+static void
+_request_free (MpsAvatarRequest *request)
+{
+  g_free (request->path);
+
+  if (request->pixbuf)
+    g_object_unref (request->pixbuf);
+
+  g_clear_error (&(request->error));
+  g_slice_free (MpsAvatarRequest, request);
+}
+
+static gboolean
+_request_done_idle_cb (gpointer userdata)
+{
+  MpsAvatarRequest *request = (MpsAvatarRequest *)userdata;
+
+  if (!g_atomic_int_get (&(request->cancelled)))
+  {
+    request->func (request,
+                   request->pixbuf,
+                   request->error,
+                   request->userdata);
+  }
+
+  return FALSE;
+}
+
+/* Averages the source texels under each destination pixel, weighting the
+ * colour by alpha so transparent texels don't darken the edges.
+ */
+static void
+_box_filter (const guint8 *src,
+             gint          src_rowstride,
+             gint          n_channels,
+             gboolean      has_alpha,
+             gint          src_x,
+             gint          src_y,
+             gint          src_size,
+             guint8       *dest,
+             gint          dest_rowstride,
+             gint          dest_size)
+{
+  gint dx, dy, x, y;
+
+  for (dy = 0; dy < dest_size; dy++)
+  {
+    gint y0 = src_y + dy * src_size / dest_size;
+    gint y1 = src_y + (dy + 1) * src_size / dest_size;
+    guint8 *out = dest + dy * dest_rowstride;
+
+    for (dx = 0; dx < dest_size; dx++, out += 4)
+    {
+      gint x0 = src_x + dx * src_size / dest_size;
+      gint x1 = src_x + (dx + 1) * src_size / dest_size;
+      guint32 r = 0, g = 0, b = 0, a = 0, count = 0;
+
+      for (y = y0; y < y1; y++)
+      {
+        const guint8 *p = src + y * src_rowstride + x0 * n_channels;
+
+        for (x = x0; x < x1; x++, p += n_channels)
+        {
+          guint32 alpha = has_alpha ? p[3] : 0xff;
+
+          r += p[0] * alpha;
+          g += p[1] * alpha;
+          b += p[2] * alpha;
+          a += alpha;
+          count++;
+        }
+      }
+
+      if (a > 0)
+      {
+        out[0] = r / a;
+        out[1] = g / a;
+        out[2] = b / a;
+        out[3] = a / count;
+      } else {
+        out[0] = out[1] = out[2] = out[3] = 0;
+      }
+    }
+  }
+}
+
+/* Scale to size x size, cropping the centre out the way PengeMagicTexture
+ * would when painting it at that size.
+ */
+GdkPixbuf *
+mps_avatar_loader_crop_and_scale (GdkPixbuf *pixbuf,
+                                  gint       size)
+{
+  GdkPixbuf *sub_pixbuf, *scaled;
+  gint width, height, crop, crop_x, crop_y;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  crop = MIN (width, height);
+  crop_x = (width - crop) / 2;
+  crop_y = (height - crop) / 2;
+
+  /* Too small to filter down, let GdkPixbuf interpolate it up */
+  if (crop < size)
+  {
+    sub_pixbuf = gdk_pixbuf_new_subpixbuf (pixbuf, crop_x, crop_y, crop, crop);
+    scaled = gdk_pixbuf_scale_simple (sub_pixbuf,
+                                      size,
+                                      size,
+                                      GDK_INTERP_BILINEAR);
+    g_object_unref (sub_pixbuf);
+
+    return scaled;
+  }
+
+  scaled = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, size, size);
+
+  _box_filter (gdk_pixbuf_get_pixels (pixbuf),
+               gdk_pixbuf_get_rowstride (pixbuf),
+               gdk_pixbuf_get_n_channels (pixbuf),
+               gdk_pixbuf_get_has_alpha (pixbuf),
+               crop_x,
+               crop_y,
+               crop,
+               gdk_pixbuf_get_pixels (scaled),
+               gdk_pixbuf_get_rowstride (scaled),
+               size);
+
+  return scaled;
+}
+
+/* Runs in a worker thread */
+static void
+_decode_func (gpointer data,
+              gpointer userdata)
+{
+  MpsAvatarRequest *request = (MpsAvatarRequest *)data;
+  struct stat st;
+  gboolean have_mtime;
+
+  /* Cards get rebound while scrolling so plenty never need decoding */
+  if (g_atomic_int_get (&(request->cancelled)))
+    goto done;
+
+  have_mtime = (request->size > 0 && g_stat (request->path, &st) == 0);
+
+  /* Scaled on an earlier run */
+  if (have_mtime)
+  {
+    request->pixbuf = mps_avatar_pack_lookup (request->path,
+                                              st.st_mtime,
+                                              request->size);
+
+    if (request->pixbuf)
+      goto done;
+  }
+
+  request->pixbuf = gdk_pixbuf_new_from_file (request->path,
+                                              &(request->error));
+
+  /* Only keep what will actually be shown */
+  if (request->pixbuf && request->size > 0)
+  {
+    GdkPixbuf *scaled;
+
+    scaled = mps_avatar_loader_crop_and_scale (request->pixbuf, request->size);
+    g_object_unref (request->pixbuf);
+    request->pixbuf = scaled;
+
+    if (have_mtime)
+      mps_avatar_pack_append (request->path, st.st_mtime, request->pixbuf);
+  }
+
+done:
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   _request_done_idle_cb,
+                   request,
+                   (GDestroyNotify)_request_free);
+}
+
+MpsAvatarRequest *
+mps_avatar_loader_load (const gchar         *path,
+                        gint                 size,
+                        MpsAvatarLoadedFunc  func,
+                        gpointer             userdata)
+{
+  MpsAvatarRequest *request;
+  GError *error = NULL;
+
+  if (!decode_pool)
+  {
+    /* Has to be ready before any worker looks at it */
+    mps_avatar_pack_init ();
+
+    decode_pool = g_thread_pool_new (_decode_func,
+                                     NULL,
+                                     MAX_THREADS,
+                                     FALSE,
+                                     &error);
+
+    if (!decode_pool)
+    {
+      g_warning (G_STRLOC ": Unable to create decode pool: %s",
+                 error->message);
+      g_clear_error (&error);
+      return NULL;
+    }
+  }
+
+  request = g_slice_new0 (MpsAvatarRequest);
+  request->path = g_strdup (path);
+  request->size = size;
+  request->func = func;
+  request->userdata = userdata;
+
+  g_thread_pool_push (decode_pool, request, NULL);
+
+  return request;
+}
+
+/* The func will not be called. Must not be used after the func has run */
+void
+mps_avatar_loader_cancel (MpsAvatarRequest *request)
+{
+  g_atomic_int_set (&(request->cancelled), TRUE);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_AVATAR_LOADER
+#define _MPS_AVATAR_LOADER
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MpsAvatarRequest MpsAvatarRequest;
+
+/* Called in the main loop. pixbuf is NULL if decoding failed */
+typedef void (*MpsAvatarLoadedFunc) (MpsAvatarRequest *request,
+                                     GdkPixbuf        *pixbuf,
+                                     const GError     *error,
+                                     gpointer          userdata);
+
+MpsAvatarRequest *mps_avatar_loader_load (const gchar         *path,
+                                          gint                 size,
+                                          MpsAvatarLoadedFunc  func,
+                                          gpointer             userdata);
+void mps_avatar_loader_cancel (MpsAvatarRequest *request);
+
+GdkPixbuf *mps_avatar_loader_crop_and_scale (GdkPixbuf *pixbuf,
+                                             gint       size);
+
+G_END_DECLS
+
+#endif /* _MPS_AVATAR_LOADER */
@@ -0,0 +1,609 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "mps-avatar-pack.h"
+
+/* File layout, all in host byte order since the pack never leaves the
+ * machine:
+ *
+ *   header
+ *   record, path (nul terminated), pixels (width * height * 4)
+ *   record, path, pixels
+ *   ...
+ *
+ * Everything is padded out to 8 bytes. A later record for the same path
+ * replaces an earlier one. Once the file passes the cap it is compacted,
+ * either at startup or by whichever append pushes it over.
+ */
+#define PACK_MAGIC "MPSAVPK1"
+#define PACK_VERSION 1
+#define PACK_MAX_SIZE (8 * 1024 * 1024)
+
+#define PAD(n) (((n) + 7) & ~7)
+
+typedef struct
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 reserved;
+} MpsAvatarPackHeader;
+
+typedef struct
+{
+  guint32 path_len; /* including the nul */
+  guint32 width;
+  guint32 height;
+  guint32 reserved;
+  gint64 mtime;
+} MpsAvatarPackRecord;
+
+typedef struct
+{
+  const MpsAvatarPackRecord *record;
+  const gchar *path;
+  const guint8 *pixels;
+  guint8 *block; /* our own copy for records appended this run */
+  guint serial; /* file order */
+} MpsAvatarPackEntry;
+
+static gchar *pack_path = NULL;
+static gsize pack_valid_length = 0; /* anything after this is junk */
+
+/* Guards everything below, the index is shared with the loader threads */
+static GStaticMutex pack_mutex = G_STATIC_MUTEX_INIT;
+static GMappedFile *pack_mapping = NULL;
+static GHashTable *pack_entries = NULL;
+static guint pack_serial = 0;
+static FILE *append_file = NULL;
+
+static gsize
+_record_size (const MpsAvatarPackRecord *record)
+{
+  return sizeof (MpsAvatarPackRecord) +
+    PAD (record->path_len) +
+    PAD (record->width * record->height * 4);
+}
+
+/* Walk the records, stopping at the first one that doesn't make sense. The
+ * list is in file order and the entries point into the contents.
+ */
+static GList *
+_scan_records (const gchar *contents,
+               gsize        length,
+               gsize       *valid_length)
+{
+  const MpsAvatarPackHeader *header;
+  GList *records = NULL;
+  gsize offset;
+
+  header = (const MpsAvatarPackHeader *)contents;
+  *valid_length = 0;
+
+  if (length < sizeof (MpsAvatarPackHeader) ||
+      memcmp (header->magic, PACK_MAGIC, 8) != 0 ||
+      header->version != PACK_VERSION)
+  {
+    return NULL;
+  }
+
+  offset = sizeof (MpsAvatarPackHeader);
+
+  while (offset + sizeof (MpsAvatarPackRecord) <= length)
+  {
+    const MpsAvatarPackRecord *record;
+    MpsAvatarPackEntry *entry;
+
+    record = (const MpsAvatarPackRecord *)(contents + offset);
+
+    if (record->path_len == 0 ||
+        record->width == 0 || record->width > 1024 ||
+        record->height == 0 || record->height > 1024 ||
+        offset + _record_size (record) > length)
+    {
+      break;
+    }
+
+    entry = g_slice_new0 (MpsAvatarPackEntry);
+    entry->record = record;
+    entry->path = (const gchar *)(record + 1);
+    entry->pixels = (const guint8 *)entry->path + PAD (record->path_len);
+    entry->serial = pack_serial++;
+
+    if (entry->path[record->path_len - 1] != '\0')
+    {
+      g_slice_free (MpsAvatarPackEntry, entry);
+      break;
+    }
+
+    records = g_list_prepend (records, entry);
+    offset += _record_size (record);
+  }
+
+  *valid_length = offset;
+
+  return g_list_reverse (records);
+}
+
+static void
+_entry_free (MpsAvatarPackEntry *entry)
+{
+  g_free (entry->block);
+  g_slice_free (MpsAvatarPackEntry, entry);
+}
+
+static gint
+_entry_serial_compare (gconstpointer a,
+                       gconstpointer b)
+{
+  const MpsAvatarPackEntry *entry_a = (const MpsAvatarPackEntry *)a;
+  const MpsAvatarPackEntry *entry_b = (const MpsAvatarPackEntry *)b;
+
+  if (entry_a->serial < entry_b->serial)
+    return -1;
+
+  return (entry_a->serial > entry_b->serial);
+}
+
+static gboolean
+_is_current (MpsAvatarPackEntry *entry)
+{
+  struct stat st;
+
+  return (g_stat (entry->path, &st) == 0 &&
+          (gint64)st.st_mtime == entry->record->mtime);
+}
+
+/* Rewrite the pack keeping only the newest record for avatars that are
+ * still current, and drop the oldest of those until it is well under the
+ * cap so we don't compact again straight away. On success the entries that
+ * survived are returned in *kept (file order) and the new length in
+ * *length.
+ */
+static gboolean
+_compact (GList  *records,
+          GList **kept,
+          gsize  *length)
+{
+  MpsAvatarPackHeader header = { PACK_MAGIC, PACK_VERSION, 0 };
+  GHashTable *newest;
+  GList *keep = NULL, *l;
+  gsize total = sizeof (MpsAvatarPackHeader);
+  gchar *tmp_path;
+  FILE *file;
+  gboolean success = TRUE;
+
+  newest = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (l = records; l; l = l->next)
+  {
+    MpsAvatarPackEntry *entry = (MpsAvatarPackEntry *)l->data;
+
+    g_hash_table_insert (newest, (gpointer)entry->path, entry);
+  }
+
+  /* Newest first so the oldest are at the end to be dropped */
+  for (l = g_list_last (records); l; l = l->prev)
+  {
+    MpsAvatarPackEntry *entry = (MpsAvatarPackEntry *)l->data;
+
+    if (g_hash_table_lookup (newest, entry->path) != entry ||
+        !_is_current (entry))
+    {
+      continue;
+    }
+
+    if (total + _record_size (entry->record) > PACK_MAX_SIZE / 2)
+      break;
+
+    total += _record_size (entry->record);
+    keep = g_list_prepend (keep, entry);
+  }
+
+  g_hash_table_destroy (newest);
+
+  tmp_path = g_strconcat (pack_path, ".tmp", NULL);
+  file = g_fopen (tmp_path, "wb");
+
+  if (!file)
+  {
+    g_warning (G_STRLOC ": Unable to write avatar pack: %s",
+               g_strerror (errno));
+    g_list_free (keep);
+    g_free (tmp_path);
+    return FALSE;
+  }
+
+  fwrite (&header, sizeof (header), 1, file);
+
+  for (l = keep; l; l = l->next)
+  {
+    MpsAvatarPackEntry *entry = (MpsAvatarPackEntry *)l->data;
+
+    fwrite (entry->record, _record_size (entry->record), 1, file);
+  }
+
+  if (fclose (file) != 0 || g_rename (tmp_path, pack_path) != 0)
+  {
+    g_warning (G_STRLOC ": Unable to write avatar pack: %s",
+               g_strerror (errno));
+    g_unlink (tmp_path);
+    success = FALSE;
+  } else {
+    g_debug (G_STRLOC ": Compacted avatar pack to %d avatars",
+             g_list_length (keep));
+  }
+
+  if (success && kept)
+    *kept = keep;
+  else
+    g_list_free (keep);
+
+  if (success && length)
+    *length = total;
+
+  g_free (tmp_path);
+
+  return success;
+}
+
+static GList *
+_map_pack (void)
+{
+  GError *error = NULL;
+
+  pack_mapping = g_mapped_file_new (pack_path, FALSE, &error);
+
+  if (!pack_mapping)
+  {
+    if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+    {
+      g_warning (G_STRLOC ": Unable to map avatar pack: %s",
+                 error->message);
+    }
+
+    g_clear_error (&error);
+    return NULL;
+  }
+
+  return _scan_records (g_mapped_file_get_contents (pack_mapping),
+                        g_mapped_file_get_length (pack_mapping),
+                        &pack_valid_length);
+}
+
+void
+mps_avatar_pack_init (void)
+{
+  GList *records, *l;
+  gchar *dir;
+
+  if (pack_entries)
+    return;
+
+  dir = g_build_filename (g_get_user_cache_dir (),
+                          "meego-panel-status",
+                          NULL);
+  g_mkdir_with_parents (dir, 0700);
+  pack_path = g_build_filename (dir, "avatars.pack", NULL);
+  g_free (dir);
+
+  pack_entries = g_hash_table_new_full (g_str_hash,
+                                        g_str_equal,
+                                        NULL,
+                                        (GDestroyNotify)_entry_free);
+
+  records = _map_pack ();
+
+  if (pack_mapping &&
+      g_mapped_file_get_length (pack_mapping) > PACK_MAX_SIZE)
+  {
+    _compact (records, NULL, NULL);
+
+    g_list_foreach (records, (GFunc)_entry_free, NULL);
+    g_list_free (records);
+    g_mapped_file_unref (pack_mapping);
+    pack_mapping = NULL;
+
+    records = _map_pack ();
+  }
+
+  /* Later records win */
+  for (l = records; l; l = l->next)
+  {
+    MpsAvatarPackEntry *entry = (MpsAvatarPackEntry *)l->data;
+
+    g_hash_table_replace (pack_entries, (gpointer)entry->path, entry);
+  }
+
+  g_list_free (records);
+}
+
+/* Must be called with the mutex held */
+static MpsAvatarPackEntry *
+_lookup_entry (const gchar *path,
+               gint64       mtime,
+               gint         width,
+               gint         height)
+{
+  MpsAvatarPackEntry *entry;
+
+  entry = g_hash_table_lookup (pack_entries, path);
+
+  if (!entry ||
+      entry->record->mtime != mtime ||
+      entry->record->width != width ||
+      entry->record->height != height)
+  {
+    return NULL;
+  }
+
+  return entry;
+}
+
+static void
+_pixbuf_unref_mapping (guchar   *pixels,
+                       gpointer  userdata)
+{
+  g_mapped_file_unref ((GMappedFile *)userdata);
+}
+
+/* The pixbuf shares the mapped memory for records from an earlier run and
+ * keeps the mapping alive, a compaction lets go of it. Records appended
+ * this run can be dropped by a compaction so those get copied.
+ */
+GdkPixbuf *
+mps_avatar_pack_lookup (const gchar *path,
+                        gint64       mtime,
+                        gint         size)
+{
+  MpsAvatarPackEntry *entry;
+  GdkPixbuf *pixbuf = NULL;
+
+  g_static_mutex_lock (&pack_mutex);
+
+  if (pack_entries)
+    entry = _lookup_entry (path, mtime, size, size);
+  else
+    entry = NULL;
+
+  if (entry && entry->block)
+  {
+    gsize n_bytes = entry->record->width * entry->record->height * 4;
+
+    pixbuf = gdk_pixbuf_new_from_data (g_memdup (entry->pixels, n_bytes),
+                                       GDK_COLORSPACE_RGB,
+                                       TRUE,
+                                       8,
+                                       entry->record->width,
+                                       entry->record->height,
+                                       entry->record->width * 4,
+                                       (GdkPixbufDestroyNotify)g_free,
+                                       NULL);
+  } else if (entry) {
+    pixbuf = gdk_pixbuf_new_from_data ((guchar *)entry->pixels,
+                                       GDK_COLORSPACE_RGB,
+                                       TRUE,
+                                       8,
+                                       entry->record->width,
+                                       entry->record->height,
+                                       entry->record->width * 4,
+                                       _pixbuf_unref_mapping,
+                                       g_mapped_file_ref (pack_mapping));
+  }
+
+  g_static_mutex_unlock (&pack_mutex);
+
+  return pixbuf;
+}
+
+static gboolean
+_open_for_append (void)
+{
+  MpsAvatarPackHeader header = { PACK_MAGIC, PACK_VERSION, 0 };
+
+  if (append_file)
+    return TRUE;
+
+  if (pack_valid_length == 0)
+  {
+    /* Start afresh if what is there couldn't be read */
+    append_file = g_fopen (pack_path, "wb");
+
+    if (append_file)
+    {
+      fwrite (&header, sizeof (header), 1, append_file);
+      pack_valid_length = sizeof (header);
+    }
+  } else {
+    /* Cut off any half written record from last time. Nothing refers to
+     * that part of the mapping.
+     */
+    append_file = g_fopen (pack_path, "r+b");
+
+    if (append_file &&
+        (ftruncate (fileno (append_file), pack_valid_length) != 0 ||
+         fseek (append_file, 0, SEEK_END) != 0))
+    {
+      fclose (append_file);
+      append_file = NULL;
+    }
+  }
+
+  if (!append_file)
+  {
+    g_warning (G_STRLOC ": Unable to open avatar pack: %s",
+               g_strerror (errno));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Must be called with the mutex held. Surviving entries from the old
+ * mapping get their own copies so it can go, the new file is only ever
+ * appended to from here on.
+ */
+static void
+_compact_in_place (void)
+{
+  GList *records, *kept = NULL, *l;
+  gsize length;
+
+  records = g_list_sort (g_hash_table_get_values (pack_entries),
+                         _entry_serial_compare);
+
+  if (!_compact (records, &kept, &length))
+  {
+    g_list_free (records);
+    return;
+  }
+
+  if (append_file)
+  {
+    fclose (append_file);
+    append_file = NULL;
+  }
+
+  pack_valid_length = length;
+
+  g_hash_table_steal_all (pack_entries);
+
+  for (l = records; l; l = l->next)
+  {
+    MpsAvatarPackEntry *entry = (MpsAvatarPackEntry *)l->data;
+
+    if (!g_list_find (kept, entry))
+    {
+      _entry_free (entry);
+      continue;
+    }
+
+    if (!entry->block)
+    {
+      entry->block = g_memdup (entry->record, _record_size (entry->record));
+      entry->record = (const MpsAvatarPackRecord *)entry->block;
+      entry->path = (const gchar *)(entry->record + 1);
+      entry->pixels = (const guint8 *)entry->path +
+        PAD (entry->record->path_len);
+    }
+
+    g_hash_table_replace (pack_entries, (gpointer)entry->path, entry);
+  }
+
+  g_list_free (kept);
+  g_list_free (records);
+
+  /* Pixbufs handed out earlier hold their own reference */
+  if (pack_mapping)
+  {
+    g_mapped_file_unref (pack_mapping);
+    pack_mapping = NULL;
+  }
+}
+
+void
+mps_avatar_pack_append (const gchar *path,
+                        gint64       mtime,
+                        GdkPixbuf   *pixbuf)
+{
+  MpsAvatarPackRecord record = { 0, };
+  MpsAvatarPackEntry *entry;
+  const guint8 *pixels;
+  guint8 *dest;
+  gint rowstride;
+  gsize size;
+  guint y;
+
+  if (!gdk_pixbuf_get_has_alpha (pixbuf) ||
+      gdk_pixbuf_get_n_channels (pixbuf) != 4)
+  {
+    return;
+  }
+
+  record.path_len = strlen (path) + 1;
+  record.width = gdk_pixbuf_get_width (pixbuf);
+  record.height = gdk_pixbuf_get_height (pixbuf);
+  record.mtime = mtime;
+
+  g_static_mutex_lock (&pack_mutex);
+
+  /* Another worker may have beaten us to it */
+  if (!pack_entries ||
+      _lookup_entry (path, mtime, record.width, record.height))
+  {
+    g_static_mutex_unlock (&pack_mutex);
+    return;
+  }
+
+  size = _record_size (&record);
+
+  if (pack_valid_length + size > PACK_MAX_SIZE)
+    _compact_in_place ();
+
+  if (!_open_for_append ())
+  {
+    g_static_mutex_unlock (&pack_mutex);
+    return;
+  }
+
+  /* Laid out exactly as in the file so it can be written in one go and
+   * looked up without a copy of its own.
+   */
+  entry = g_slice_new0 (MpsAvatarPackEntry);
+  entry->block = g_malloc0 (size);
+  entry->record = (const MpsAvatarPackRecord *)entry->block;
+  entry->path = (const gchar *)(entry->record + 1);
+  entry->pixels = (const guint8 *)entry->path + PAD (record.path_len);
+  entry->serial = pack_serial++;
+
+  memcpy (entry->block, &record, sizeof (record));
+  memcpy ((gchar *)entry->path, path, record.path_len);
+
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  dest = (guint8 *)entry->pixels;
+
+  for (y = 0; y < record.height; y++)
+    memcpy (dest + y * record.width * 4,
+            pixels + y * rowstride,
+            record.width * 4);
+
+  if (fwrite (entry->block, size, 1, append_file) == 1 &&
+      fflush (append_file) == 0)
+  {
+    pack_valid_length += size;
+    g_hash_table_replace (pack_entries, (gpointer)entry->path, entry);
+  } else {
+    g_warning (G_STRLOC ": Unable to write avatar pack: %s",
+               g_strerror (errno));
+    _entry_free (entry);
+
+    /* Truncate back to the last good record when next opened */
+    fclose (append_file);
+    append_file = NULL;
+  }
+
+  g_static_mutex_unlock (&pack_mutex);
+}
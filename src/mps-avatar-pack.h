@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_AVATAR_PACK
+#define _MPS_AVATAR_PACK
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/* An on-disk pack of prescaled RGBA avatars keyed by source path and
+ * modification time, mapped in at startup so they need no decoding.
+ *
+ * mps_avatar_pack_init must be called from the main thread before any
+ * worker uses the pack, the other functions are safe from any thread.
+ */
+void mps_avatar_pack_init (void);
+
+GdkPixbuf *mps_avatar_pack_lookup (const gchar *path,
+                                   gint64       mtime,
+                                   gint         size);
+void mps_avatar_pack_append (const gchar *path,
+                             gint64       mtime,
+                             GdkPixbuf   *pixbuf);
+
+G_END_DECLS
+
+#endif /* _MPS_AVATAR_PACK */
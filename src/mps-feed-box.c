@@ -0,0 +1,1029 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A scrollable list of feed items. The items are kept as data and cards are
+ * only bound to the rows that are in, or close to, the visible area. Cards
+ * that scroll out of range are hidden and rebound to other rows, so the
+ * number of live actors stays constant no matter how long the feed gets.
+ */
+
+#include "mps-feed-box.h"
+#include "mps-tweet-card.h"
+#include "mps-insert-scheduler.h"
+
+static void mx_scrollable_iface_init (MxScrollableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MpsFeedBox, mps_feed_box, MX_TYPE_WIDGET,
+                         G_IMPLEMENT_INTERFACE (MX_TYPE_SCROLLABLE,
+                                                mx_scrollable_iface_init))
+
+#define GET_PRIVATE_REAL(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), MPS_TYPE_FEED_BOX, MpsFeedBoxPrivate))
+#define GET_PRIVATE(o) ((MpsFeedBox *)o)->priv
+
+typedef struct {
+  MpsItem *item;
+  ClutterActor *card;
+  GSequenceIter *iter;
+
+  /* Copies of the post folded into this row, 0 if none were */
+  guint occurrences;
+
+  /* Replies and burst posts folded into this row and whether they are
+   * shown
+   */
+  guint n_replies;
+  guint n_more;
+  gboolean expanded;
+
+  /* Insertion animation state */
+  gdouble reveal;
+  guint8 opacity;
+} MpsFeedBoxRow;
+
+struct _MpsFeedBoxPrivate {
+  GSequence *rows;
+  GHashTable *uuid_to_row;
+
+  GList *bound_rows;
+  GQueue *spare_cards;
+
+  MxAdjustment *hadjustment;
+  MxAdjustment *vadjustment;
+
+  MpsFeedBoxFactoryFunc func;
+  gpointer userdata;
+
+  MpsInsertScheduler *scheduler;
+
+  /* Cards are bound from a repaint func, ahead of the layout pass, so that
+   * allocate only ever positions cards that are already parented.
+   */
+  guint bindings_id;
+  gfloat page_height;
+};
+
+enum
+{
+  PROP_0,
+  PROP_HADJUST,
+  PROP_VADJUST
+};
+
+#define ROW_HEIGHT 84.0
+#define OVERSCAN_ROWS 2
+#define MAX_SPARE_CARDS 8
+
+#define THRESHOLD 5
+#define REVEAL_DELAY 600
+#define REVEAL_DURATION 400
+#define FADE_DELAY 850
+#define FADE_DURATION 150
+
+static void
+mps_feed_box_row_free (MpsFeedBoxRow *row)
+{
+  mps_item_unref (row->item);
+  g_slice_free (MpsFeedBoxRow, row);
+}
+
+static gdouble
+_get_scroll_offset (MpsFeedBox *box)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  if (!priv->vadjustment)
+    return 0.0;
+
+  return mx_adjustment_get_value (priv->vadjustment);
+}
+
+/* Rows waiting for, or in the middle of, their insertion animation are laid
+ * out at full height but painted collapsed, so everything below them is drawn
+ * shifted up. There are at most THRESHOLD + 1 of them so their positions are
+ * looked up once and kept here for the rest of the pass.
+ */
+typedef struct
+{
+  gint positions[THRESHOLD + 1];
+  gfloat heights[THRESHOLD + 1];
+  guint n_rows;
+  gfloat total;
+} MpsFeedBoxCollapse;
+
+static void
+_add_collapsed_row (MpsFeedBoxRow      *row,
+                    MpsFeedBoxCollapse *collapse)
+{
+  if (collapse->n_rows >= G_N_ELEMENTS (collapse->positions))
+    return;
+
+  collapse->positions[collapse->n_rows] =
+    g_sequence_iter_get_position (row->iter);
+  collapse->heights[collapse->n_rows] = (1.0 - row->reveal) * ROW_HEIGHT;
+  collapse->total += collapse->heights[collapse->n_rows];
+  collapse->n_rows++;
+}
+
+static void
+_get_collapse (MpsFeedBox         *box,
+               MpsFeedBoxCollapse *collapse)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  collapse->n_rows = 0;
+  collapse->total = 0.0;
+
+  mps_insert_scheduler_foreach (priv->scheduler,
+                                (GFunc)_add_collapsed_row,
+                                collapse);
+}
+
+/* How far the row at position is drawn shifted up */
+static gfloat
+_collapsed_height_above (const MpsFeedBoxCollapse *collapse,
+                         gint                      position)
+{
+  gfloat height = 0.0;
+  guint i;
+
+  for (i = 0; i < collapse->n_rows; i++)
+  {
+    if (collapse->positions[i] < position)
+      height += collapse->heights[i];
+  }
+
+  return height;
+}
+
+static gfloat
+_row_y (MpsFeedBox *box,
+        gint        position)
+{
+  return position * ROW_HEIGHT;
+}
+
+static gfloat
+_content_height (MpsFeedBox *box)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  return g_sequence_get_length (priv->rows) * ROW_HEIGHT;
+}
+
+static void
+_release_card (MpsFeedBox    *box,
+               MpsFeedBoxRow *row)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  priv->bound_rows = g_list_remove (priv->bound_rows, row);
+
+  if (g_queue_get_length (priv->spare_cards) < MAX_SPARE_CARDS)
+  {
+    clutter_actor_hide (row->card);
+    g_queue_push_head (priv->spare_cards, row->card);
+  } else {
+    clutter_actor_destroy (row->card);
+  }
+
+  row->card = NULL;
+}
+
+static void
+_bind_card (MpsFeedBox    *box,
+            MpsFeedBoxRow *row)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  ClutterActor *card;
+
+  card = g_queue_pop_head (priv->spare_cards);
+
+  if (card)
+  {
+    g_object_set (card,
+                  "item", row->item,
+                  NULL);
+  } else {
+    if (priv->func)
+    {
+      card = priv->func (box, row->item, priv->userdata);
+    } else {
+      card = g_object_new (MPS_TYPE_TWEET_CARD,
+                           "item", row->item,
+                           NULL);
+    }
+
+    clutter_actor_set_parent (card, CLUTTER_ACTOR (box));
+  }
+
+  /* Spare cards may still show the state from their last row */
+  if (MPS_IS_TWEET_CARD (card))
+  {
+    mps_tweet_card_set_occurrences (MPS_TWEET_CARD (card), row->occurrences);
+    mps_tweet_card_set_thread (MPS_TWEET_CARD (card),
+                               row->n_replies,
+                               row->n_more,
+                               row->expanded);
+  }
+
+  clutter_actor_set_opacity (card, row->opacity);
+  clutter_actor_show (card);
+
+  row->card = card;
+  priv->bound_rows = g_list_prepend (priv->bound_rows, row);
+}
+
+/* Make sure exactly the rows in and near the visible area have cards. Returns
+ * TRUE if any new cards were bound and so need allocating.
+ */
+static gboolean
+_update_bindings (MpsFeedBox *box,
+                  gfloat      page_height)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxCollapse collapse;
+  GSequenceIter *iter;
+  GList *l, *next;
+  gdouble offset;
+  gint n_rows, first, last, extra, i;
+  gboolean bound_new = FALSE;
+
+  n_rows = g_sequence_get_length (priv->rows);
+  offset = _get_scroll_offset (box);
+
+  /* Collapsed rows pull later rows up into view */
+  _get_collapse (box, &collapse);
+  extra = (gint)(collapse.total / ROW_HEIGHT) + 1;
+
+  first = (gint)(offset / ROW_HEIGHT) - OVERSCAN_ROWS;
+  last = (gint)((offset + page_height) / ROW_HEIGHT) + OVERSCAN_ROWS + extra;
+
+  first = MAX (first, 0);
+  last = MIN (last, n_rows - 1);
+
+  for (l = priv->bound_rows; l; l = next)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)l->data;
+    gint position;
+
+    next = l->next;
+    position = g_sequence_iter_get_position (row->iter);
+
+    if (position < first || position > last)
+      _release_card (box, row);
+  }
+
+  if (first > last)
+    return FALSE;
+
+  iter = g_sequence_get_iter_at_pos (priv->rows, first);
+
+  for (i = first; i <= last; i++, iter = g_sequence_iter_next (iter))
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)g_sequence_get (iter);
+
+    if (!row->card)
+    {
+      _bind_card (box, row);
+      bound_new = TRUE;
+    }
+
+    if (MX_IS_STYLABLE (row->card))
+    {
+      mx_stylable_set_style_class (MX_STYLABLE (row->card),
+                                   (i == n_rows - 1) ?
+                                   "mps-tweet-card-last" : NULL);
+    }
+  }
+
+  return bound_new;
+}
+
+static void
+_finish_reveal (MpsFeedBoxRow *row)
+{
+  row->reveal = 1.0;
+  row->opacity = 0xff;
+
+  if (row->card)
+    clutter_actor_set_opacity (row->card, row->opacity);
+}
+
+static void
+_reveal_row_cb (MpsFeedBoxRow *row,
+                guint          msecs,
+                MpsFeedBox    *box)
+{
+  gdouble fade;
+
+  if (msecs >= FADE_DELAY + FADE_DURATION)
+  {
+    _finish_reveal (row);
+  } else {
+    row->reveal = CLAMP (((gint)msecs - REVEAL_DELAY) / (gdouble)REVEAL_DURATION,
+                         0.0, 1.0);
+
+    /* Ease out quad */
+    fade = CLAMP (((gint)msecs - FADE_DELAY) / (gdouble)FADE_DURATION,
+                  0.0, 1.0);
+    row->opacity = (guint8)(0xff * fade * (2.0 - fade));
+
+    if (row->card)
+      clutter_actor_set_opacity (row->card, row->opacity);
+  }
+
+  /* The layout already has the row at full height, only the paint moves */
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (box));
+}
+
+static gboolean
+_update_bindings_cb (gpointer userdata)
+{
+  MpsFeedBox *box = MPS_FEED_BOX (userdata);
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  priv->bindings_id = 0;
+
+  if (_update_bindings (box, priv->page_height))
+    clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
+  else
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (box));
+
+  return FALSE;
+}
+
+/* Rebind before the next frame is laid out */
+static void
+_queue_update_bindings (MpsFeedBox *box)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  if (priv->bindings_id)
+    return;
+
+  priv->bindings_id = clutter_threads_add_repaint_func (_update_bindings_cb,
+                                                        box,
+                                                        NULL);
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (box));
+}
+
+static void
+_adjustment_value_notify_cb (MxAdjustment *adjustment,
+                             GParamSpec   *pspec,
+                             MpsFeedBox   *box)
+{
+  _queue_update_bindings (box);
+}
+
+static void
+scrollable_set_adjustments (MxScrollable *scrollable,
+                            MxAdjustment *hadjustment,
+                            MxAdjustment *vadjustment)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (scrollable);
+
+  if (hadjustment != priv->hadjustment)
+  {
+    if (priv->hadjustment)
+      g_object_unref (priv->hadjustment);
+
+    priv->hadjustment = hadjustment ? g_object_ref (hadjustment) : NULL;
+  }
+
+  if (vadjustment != priv->vadjustment)
+  {
+    if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            _adjustment_value_notify_cb,
+                                            scrollable);
+      g_object_unref (priv->vadjustment);
+    }
+
+    priv->vadjustment = vadjustment ? g_object_ref (vadjustment) : NULL;
+
+    if (priv->vadjustment)
+    {
+      g_signal_connect (priv->vadjustment,
+                        "notify::value",
+                        (GCallback)_adjustment_value_notify_cb,
+                        scrollable);
+    }
+  }
+}
+
+static void
+scrollable_get_adjustments (MxScrollable  *scrollable,
+                            MxAdjustment **hadjustment,
+                            MxAdjustment **vadjustment)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (scrollable);
+  MxAdjustment *adjustment;
+
+  if (hadjustment)
+  {
+    if (!priv->hadjustment)
+    {
+      adjustment = mx_adjustment_new ();
+      scrollable_set_adjustments (scrollable, adjustment, priv->vadjustment);
+      g_object_unref (adjustment);
+    }
+
+    *hadjustment = priv->hadjustment;
+  }
+
+  if (vadjustment)
+  {
+    if (!priv->vadjustment)
+    {
+      adjustment = mx_adjustment_new ();
+      scrollable_set_adjustments (scrollable, priv->hadjustment, adjustment);
+      g_object_unref (adjustment);
+    }
+
+    *vadjustment = priv->vadjustment;
+  }
+}
+
+static void
+mx_scrollable_iface_init (MxScrollableIface *iface)
+{
+  iface->set_adjustments = scrollable_set_adjustments;
+  iface->get_adjustments = scrollable_get_adjustments;
+}
+
+static void
+mps_feed_box_get_property (GObject *object, guint property_id,
+                           GValue *value, GParamSpec *pspec)
+{
+  MxAdjustment *adjustment;
+
+  switch (property_id) {
+    case PROP_HADJUST:
+      scrollable_get_adjustments (MX_SCROLLABLE (object), &adjustment, NULL);
+      g_value_set_object (value, adjustment);
+      break;
+    case PROP_VADJUST:
+      scrollable_get_adjustments (MX_SCROLLABLE (object), NULL, &adjustment);
+      g_value_set_object (value, adjustment);
+      break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+mps_feed_box_set_property (GObject *object, guint property_id,
+                           const GValue *value, GParamSpec *pspec)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (object);
+
+  switch (property_id) {
+    case PROP_HADJUST:
+      scrollable_set_adjustments (MX_SCROLLABLE (object),
+                                  g_value_get_object (value),
+                                  priv->vadjustment);
+      break;
+    case PROP_VADJUST:
+      scrollable_set_adjustments (MX_SCROLLABLE (object),
+                                  priv->hadjustment,
+                                  g_value_get_object (value));
+      break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+mps_feed_box_dispose (GObject *object)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (object);
+  ClutterActor *card;
+
+  if (priv->bindings_id)
+  {
+    clutter_threads_remove_repaint_func (priv->bindings_id);
+    priv->bindings_id = 0;
+  }
+
+  if (priv->scheduler)
+  {
+    mps_insert_scheduler_free (priv->scheduler);
+    priv->scheduler = NULL;
+  }
+
+  while (priv->bound_rows)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)priv->bound_rows->data;
+
+    clutter_actor_destroy (row->card);
+    row->card = NULL;
+    priv->bound_rows = g_list_delete_link (priv->bound_rows,
+                                           priv->bound_rows);
+  }
+
+  while ((card = g_queue_pop_head (priv->spare_cards)))
+    clutter_actor_destroy (card);
+
+  scrollable_set_adjustments (MX_SCROLLABLE (object), NULL, NULL);
+
+  G_OBJECT_CLASS (mps_feed_box_parent_class)->dispose (object);
+}
+
+static void
+mps_feed_box_finalize (GObject *object)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (object);
+
+  g_hash_table_unref (priv->uuid_to_row);
+  g_sequence_free (priv->rows);
+  g_queue_free (priv->spare_cards);
+
+  G_OBJECT_CLASS (mps_feed_box_parent_class)->finalize (object);
+}
+
+static void
+mps_feed_box_get_preferred_width (ClutterActor *actor,
+                                  gfloat        for_height,
+                                  gfloat       *min_width_p,
+                                  gfloat       *natural_width_p)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (actor);
+  MxPadding padding;
+  gfloat nat_w = 0.0;
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  if (priv->bound_rows)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)priv->bound_rows->data;
+
+    clutter_actor_get_preferred_width (row->card, ROW_HEIGHT, NULL, &nat_w);
+  }
+
+  if (min_width_p)
+    *min_width_p = padding.left + padding.right;
+
+  if (natural_width_p)
+    *natural_width_p = padding.left + padding.right + nat_w;
+}
+
+static void
+mps_feed_box_get_preferred_height (ClutterActor *actor,
+                                   gfloat        for_width,
+                                   gfloat       *min_height_p,
+                                   gfloat       *natural_height_p)
+{
+  MxPadding padding;
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  if (min_height_p)
+    *min_height_p = padding.top + padding.bottom;
+
+  if (natural_height_p)
+  {
+    *natural_height_p = padding.top + padding.bottom +
+      _content_height (MPS_FEED_BOX (actor));
+  }
+}
+
+static void
+mps_feed_box_allocate (ClutterActor           *actor,
+                       const ClutterActorBox  *box,
+                       ClutterAllocationFlags  flags)
+{
+  MpsFeedBox *self = MPS_FEED_BOX (actor);
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (actor);
+  MxPadding padding;
+  gfloat width, height, content_height;
+  GList *l;
+
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->allocate (actor,
+                                                             box,
+                                                             flags);
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  width = box->x2 - box->x1;
+  height = box->y2 - box->y1;
+  content_height = _content_height (self) + padding.top + padding.bottom;
+
+  if (priv->hadjustment)
+  {
+    mx_adjustment_set_values (priv->hadjustment,
+                              0, 0, width,
+                              1, width, width);
+  }
+
+  if (priv->vadjustment)
+  {
+    gdouble value;
+
+    value = CLAMP (mx_adjustment_get_value (priv->vadjustment),
+                   0, MAX (0, content_height - height));
+    mx_adjustment_set_values (priv->vadjustment,
+                              value,
+                              0,
+                              content_height,
+                              ROW_HEIGHT,
+                              height,
+                              height);
+  }
+
+  /* A taller page needs more cards, they get bound before the next frame */
+  if (height != priv->page_height)
+  {
+    priv->page_height = height;
+    _queue_update_bindings (self);
+  }
+
+  for (l = priv->bound_rows; l; l = l->next)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)l->data;
+    ClutterActorBox child_box;
+
+    child_box.x1 = padding.left;
+    child_box.x2 = width - padding.right;
+    child_box.y1 = padding.top +
+      (gint)_row_y (self, g_sequence_iter_get_position (row->iter));
+    child_box.y2 = child_box.y1 + ROW_HEIGHT;
+
+    clutter_actor_allocate (row->card, &child_box, flags);
+  }
+}
+
+static void
+_paint_visible_cards (MpsFeedBox *box)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxCollapse collapse;
+  gdouble offset;
+  gfloat height;
+  gboolean animating;
+  GList *l;
+
+  offset = _get_scroll_offset (box);
+  height = clutter_actor_get_height (CLUTTER_ACTOR (box));
+  animating = (mps_insert_scheduler_get_n_pending (priv->scheduler) > 0);
+
+  if (animating)
+    _get_collapse (box, &collapse);
+
+  for (l = priv->bound_rows; l; l = l->next)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)l->data;
+    ClutterActorBox child_box;
+    gfloat shift = 0.0;
+
+    clutter_actor_get_allocation_box (row->card, &child_box);
+
+    if (animating)
+    {
+      gint position = g_sequence_iter_get_position (row->iter);
+
+      shift = _collapsed_height_above (&collapse, position);
+    }
+
+    /* Overscan rows are bound but not drawn */
+    if (child_box.y2 - shift < offset ||
+        child_box.y1 - shift > offset + height)
+      continue;
+
+    if (row->reveal <= 0.0)
+      continue;
+
+    if (shift == 0.0 && row->reveal >= 1.0)
+    {
+      clutter_actor_paint (row->card);
+      continue;
+    }
+
+    cogl_push_matrix ();
+    cogl_translate (0, -shift, 0);
+
+    /* Only the revealed part of a row shows, the rows below cover the rest */
+    if (row->reveal < 1.0)
+    {
+      cogl_clip_push_rectangle (child_box.x1,
+                                child_box.y1,
+                                child_box.x2,
+                                child_box.y1 + row->reveal * ROW_HEIGHT);
+      clutter_actor_paint (row->card);
+      cogl_clip_pop ();
+    } else {
+      clutter_actor_paint (row->card);
+    }
+
+    cogl_pop_matrix ();
+  }
+}
+
+static void
+mps_feed_box_paint (ClutterActor *actor)
+{
+  gint offset = (gint)_get_scroll_offset (MPS_FEED_BOX (actor));
+
+  /* Keep the background in place while the content scrolls */
+  cogl_translate (0, offset, 0);
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->paint (actor);
+  cogl_translate (0, -offset, 0);
+
+  _paint_visible_cards (MPS_FEED_BOX (actor));
+}
+
+static void
+mps_feed_box_pick (ClutterActor       *actor,
+                   const ClutterColor *color)
+{
+  gint offset = (gint)_get_scroll_offset (MPS_FEED_BOX (actor));
+
+  cogl_translate (0, offset, 0);
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->pick (actor, color);
+  cogl_translate (0, -offset, 0);
+
+  _paint_visible_cards (MPS_FEED_BOX (actor));
+}
+
+static void
+mps_feed_box_apply_transform (ClutterActor *actor,
+                              CoglMatrix   *matrix)
+{
+  gint offset = (gint)_get_scroll_offset (MPS_FEED_BOX (actor));
+
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->apply_transform (actor,
+                                                                    matrix);
+
+  cogl_matrix_translate (matrix, 0, -offset, 0);
+}
+
+static void
+mps_feed_box_map (ClutterActor *actor)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (actor);
+  GList *l;
+
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->map (actor);
+
+  for (l = priv->bound_rows; l; l = l->next)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)l->data;
+
+    clutter_actor_map (row->card);
+  }
+}
+
+static void
+mps_feed_box_unmap (ClutterActor *actor)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (actor);
+  GList *l;
+
+  CLUTTER_ACTOR_CLASS (mps_feed_box_parent_class)->unmap (actor);
+
+  /* Nobody is watching so there is no point animating */
+  if (priv->scheduler)
+    mps_insert_scheduler_finish_all (priv->scheduler);
+
+  for (l = priv->bound_rows; l; l = l->next)
+  {
+    MpsFeedBoxRow *row = (MpsFeedBoxRow *)l->data;
+
+    clutter_actor_unmap (row->card);
+  }
+}
+
+static void
+mps_feed_box_class_init (MpsFeedBoxClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (MpsFeedBoxPrivate));
+
+  object_class->get_property = mps_feed_box_get_property;
+  object_class->set_property = mps_feed_box_set_property;
+  object_class->dispose = mps_feed_box_dispose;
+  object_class->finalize = mps_feed_box_finalize;
+
+  actor_class->get_preferred_width = mps_feed_box_get_preferred_width;
+  actor_class->get_preferred_height = mps_feed_box_get_preferred_height;
+  actor_class->allocate = mps_feed_box_allocate;
+  actor_class->paint = mps_feed_box_paint;
+  actor_class->pick = mps_feed_box_pick;
+  actor_class->apply_transform = mps_feed_box_apply_transform;
+  actor_class->map = mps_feed_box_map;
+  actor_class->unmap = mps_feed_box_unmap;
+
+  g_object_class_override_property (object_class,
+                                    PROP_HADJUST,
+                                    "horizontal-adjustment");
+  g_object_class_override_property (object_class,
+                                    PROP_VADJUST,
+                                    "vertical-adjustment");
+}
+
+static void
+mps_feed_box_init (MpsFeedBox *self)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE_REAL (self);
+
+  self->priv = priv;
+
+  priv->rows = g_sequence_new ((GDestroyNotify)mps_feed_box_row_free);
+  /* Keyed on the uuid of the row's item */
+  priv->uuid_to_row = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->spare_cards = g_queue_new ();
+  priv->scheduler =
+    mps_insert_scheduler_new (FADE_DELAY + FADE_DURATION,
+                              THRESHOLD + 1,
+                              (MpsInsertSchedulerFunc)_reveal_row_cb,
+                              self);
+}
+
+ClutterActor *
+mps_feed_box_new (void)
+{
+  return g_object_new (MPS_TYPE_FEED_BOX, NULL);
+}
+
+void
+mps_feed_box_set_factory_func (MpsFeedBox            *box,
+                               MpsFeedBoxFactoryFunc  func,
+                               gpointer               userdata)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  priv->func = func;
+  priv->userdata = userdata;
+}
+
+void
+mps_feed_box_insert_item (MpsFeedBox *box,
+                          MpsItem    *item,
+                          gint        position,
+                          gboolean    animate)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxRow *row;
+  gint n_rows;
+
+  if (g_hash_table_lookup (priv->uuid_to_row, item->uuid))
+  {
+    mps_feed_box_update_item (box, item);
+    return;
+  }
+
+  n_rows = g_sequence_get_length (priv->rows);
+
+  if (position < 0 || position > n_rows)
+    position = n_rows;
+
+  row = g_slice_new0 (MpsFeedBoxRow);
+  row->item = mps_item_ref (item);
+  row->iter = g_sequence_insert_before (g_sequence_get_iter_at_pos (priv->rows,
+                                                                    position),
+                                        row);
+
+  g_hash_table_insert (priv->uuid_to_row, (gpointer)row->item->uuid, row);
+
+  if (animate && CLUTTER_ACTOR_IS_MAPPED (box))
+  {
+    row->reveal = 0.0;
+    row->opacity = 0;
+
+    /* This finishes off the oldest pending rows if there are too many */
+    mps_insert_scheduler_push (priv->scheduler, row);
+  } else {
+    _finish_reveal (row);
+  }
+
+  _queue_update_bindings (box);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
+}
+
+void
+mps_feed_box_update_item (MpsFeedBox *box,
+                          MpsItem    *item)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxRow *row;
+
+  row = g_hash_table_lookup (priv->uuid_to_row, item->uuid);
+
+  if (!row)
+    return;
+
+  /* The key points into the old item so swap it before letting that go */
+  mps_item_ref (item);
+  g_hash_table_steal (priv->uuid_to_row, item->uuid);
+  g_hash_table_insert (priv->uuid_to_row, (gpointer)item->uuid, row);
+  mps_item_unref (row->item);
+  row->item = item;
+
+  if (row->card)
+  {
+    g_object_set (row->card,
+                  "item", item,
+                  NULL);
+  }
+}
+
+void
+mps_feed_box_remove_item (MpsFeedBox  *box,
+                          const gchar *uuid)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxRow *row;
+
+  row = g_hash_table_lookup (priv->uuid_to_row, uuid);
+
+  if (!row)
+    return;
+
+  mps_insert_scheduler_remove (priv->scheduler, row);
+
+  if (row->card)
+    _release_card (box, row);
+
+  /* The uuid may belong to the row's item so drop the key before the row */
+  g_hash_table_remove (priv->uuid_to_row, uuid);
+  g_sequence_remove (row->iter);
+
+  _queue_update_bindings (box);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
+}
+
+void
+mps_feed_box_set_item_occurrences (MpsFeedBox  *box,
+                                   const gchar *uuid,
+                                   guint        occurrences)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxRow *row;
+
+  row = g_hash_table_lookup (priv->uuid_to_row, uuid);
+
+  if (!row)
+    return;
+
+  row->occurrences = occurrences;
+
+  if (row->card && MPS_IS_TWEET_CARD (row->card))
+    mps_tweet_card_set_occurrences (MPS_TWEET_CARD (row->card), occurrences);
+}
+
+void
+mps_feed_box_set_item_thread (MpsFeedBox  *box,
+                              const gchar *uuid,
+                              guint        n_replies,
+                              guint        n_more,
+                              gboolean     expanded)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+  MpsFeedBoxRow *row;
+
+  row = g_hash_table_lookup (priv->uuid_to_row, uuid);
+
+  if (!row)
+    return;
+
+  row->n_replies = n_replies;
+  row->n_more = n_more;
+  row->expanded = expanded;
+
+  if (row->card && MPS_IS_TWEET_CARD (row->card))
+  {
+    mps_tweet_card_set_thread (MPS_TWEET_CARD (row->card),
+                               n_replies,
+                               n_more,
+                               expanded);
+  }
+}
+
+gboolean
+mps_feed_box_has_item (MpsFeedBox  *box,
+                       const gchar *uuid)
+{
+  MpsFeedBoxPrivate *priv = GET_PRIVATE (box);
+
+  return (g_hash_table_lookup (priv->uuid_to_row, uuid) != NULL);
+}
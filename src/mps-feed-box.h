@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_FEED_BOX
+#define _MPS_FEED_BOX
+
+#include <glib-object.h>
+#include <mx/mx.h>
+#include "mps-item.h"
+
+G_BEGIN_DECLS
+
+#define MPS_TYPE_FEED_BOX mps_feed_box_get_type()
+
+#define MPS_FEED_BOX(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), MPS_TYPE_FEED_BOX, MpsFeedBox))
+
+#define MPS_FEED_BOX_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), MPS_TYPE_FEED_BOX, MpsFeedBoxClass))
+
+#define MPS_IS_FEED_BOX(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MPS_TYPE_FEED_BOX))
+
+#define MPS_IS_FEED_BOX_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), MPS_TYPE_FEED_BOX))
+
+#define MPS_FEED_BOX_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), MPS_TYPE_FEED_BOX, MpsFeedBoxClass))
+
+typedef struct _MpsFeedBoxPrivate MpsFeedBoxPrivate;
+
+typedef struct {
+  MxWidget parent;
+  MpsFeedBoxPrivate *priv;
+} MpsFeedBox;
+
+typedef struct {
+  MxWidgetClass parent_class;
+} MpsFeedBoxClass;
+
+GType mps_feed_box_get_type (void);
+
+ClutterActor *mps_feed_box_new (void);
+
+typedef ClutterActor *(*MpsFeedBoxFactoryFunc) (MpsFeedBox *box,
+                                                MpsItem    *item,
+                                                gpointer    userdata);
+void mps_feed_box_set_factory_func (MpsFeedBox            *box,
+                                    MpsFeedBoxFactoryFunc  func,
+                                    gpointer               userdata);
+
+void mps_feed_box_insert_item (MpsFeedBox *box,
+                               MpsItem    *item,
+                               gint        position,
+                               gboolean    animate);
+void mps_feed_box_update_item (MpsFeedBox *box,
+                               MpsItem    *item);
+void mps_feed_box_remove_item (MpsFeedBox  *box,
+                               const gchar *uuid);
+void mps_feed_box_set_item_occurrences (MpsFeedBox  *box,
+                                        const gchar *uuid,
+                                        guint        occurrences);
+void mps_feed_box_set_item_thread (MpsFeedBox  *box,
+                                   const gchar *uuid,
+                                   guint        n_replies,
+                                   guint        n_more,
+                                   gboolean     expanded);
+gboolean mps_feed_box_has_item (MpsFeedBox  *box,
+                                const gchar *uuid);
+
+G_END_DECLS
+
+#endif /* _MPS_FEED_BOX */
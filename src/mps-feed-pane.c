@@ -43,11 +43,15 @@
 #include <meego-panel/mpl-panel-common.h>
 
 #include "mps-view-bridge.h"
+#include "mps-feed-box.h"
 #include "mps-feed-pane.h"
 #include "mps-tweet-card.h"
 #include "mps-geotag-pane.h"
 
+#include "mps-governor.h"
+
 #include "sw-online.h"
+#include "sw-marshals.h"
 
 G_DEFINE_TYPE (MpsFeedPane, mps_feed_pane, MX_TYPE_TABLE)
 
@@ -62,6 +66,16 @@ struct _MpsFeedPanePrivate {
   SwClientItemView *view;
   MpsViewBridge *bridge;
 
+  /* Tells us when libsocialweb comes back after going away */
+  DBusGProxy *bus_proxy;
+  gboolean service_lost;
+
+  /* Rows for a page were added and the feed box hasn't grown for them yet */
+  gboolean loading_older;
+
+  /* Connectivity changed while hidden, recheck the capabilities on show */
+  gboolean caps_stale;
+
   ClutterActor *update_hbox;
   ClutterActor *entry;
   ClutterActor *update_button;
@@ -70,7 +84,7 @@ struct _MpsFeedPanePrivate {
   ClutterActor *something_wrong_label;
 
   ClutterActor *scroll_view;
-  ClutterActor *box_layout;
+  ClutterActor *feed_box;
 
   ClutterActor *progress_label;
 
@@ -95,8 +109,21 @@ enum
 
 #define NOT_ONLINE_TEXT _("Unable to update status: You're not online.")
 
+#define SW_SERVICE_NAME "org.gnome.libsocialweb"
+
+/* Retention window for the feed */
+#define FEED_MAX_ITEMS 200
+#define FEED_MAX_AGE (7 * 24 * 60 * 60) /* 1 week */
+#define FEED_PAGE_ITEMS 20
+
 
 static void _online_notify_cb (gboolean online, gpointer userdata);
+static void _visibility_notify_cb (gboolean visible, gpointer userdata);
+static void _name_owner_changed_cb (DBusGProxy  *proxy,
+                                    const gchar *name,
+                                    const gchar *old_owner,
+                                    const gchar *new_owner,
+                                    gpointer     userdata);
 
 static void
 mps_feed_pane_get_property (GObject *object, guint property_id,
@@ -163,7 +190,18 @@ mps_feed_pane_dispose (GObject *object)
     priv->bridge = NULL;
   }
 
+  if (priv->bus_proxy)
+  {
+    dbus_g_proxy_disconnect_signal (priv->bus_proxy,
+                                    "NameOwnerChanged",
+                                    (GCallback)_name_owner_changed_cb,
+                                    object);
+    g_object_unref (priv->bus_proxy);
+    priv->bus_proxy = NULL;
+  }
+
   sw_online_remove_notify (_online_notify_cb, object);
+  mps_governor_remove_notify (_visibility_notify_cb, object);
 
   G_OBJECT_CLASS (mps_feed_pane_parent_class)->dispose (object);
 }
@@ -182,6 +220,17 @@ _client_view_opened_cb (SwClientService  *client,
   MpsFeedPane *pane = MPS_FEED_PANE (userdata);
   MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
 
+  /* Disposed while the view was being opened */
+  if (!priv->bridge)
+  {
+    g_object_unref (pane);
+    return;
+  }
+
+  /* Reopened, the bridge reconciles the new view against the old one */
+  if (priv->view)
+    g_object_unref (priv->view);
+
   priv->view = g_object_ref (view);
 
   mps_view_bridge_set_view (priv->bridge, view);
@@ -189,6 +238,67 @@ _client_view_opened_cb (SwClientService  *client,
   g_object_unref (pane);
 }
 
+static void
+_open_view (MpsFeedPane *pane)
+{
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+  GHashTable *params;
+
+  /* Don't ask for more than we are going to keep */
+  params = g_hash_table_new_full (g_str_hash,
+                                  g_str_equal,
+                                  NULL,
+                                  g_free);
+  g_hash_table_insert (params,
+                       "count",
+                       g_strdup_printf ("%d", FEED_MAX_ITEMS));
+
+  sw_client_service_query_open_view (priv->service,
+                                     "feed",
+                                     params,
+                                     _client_view_opened_cb,
+                                     g_object_ref (pane));
+  g_hash_table_destroy (params);
+}
+
+static void
+_name_owner_changed_cb (DBusGProxy  *proxy,
+                        const gchar *name,
+                        const gchar *old_owner,
+                        const gchar *new_owner,
+                        gpointer     userdata)
+{
+  MpsFeedPane *pane = MPS_FEED_PANE (userdata);
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+  gboolean had_owner, has_owner;
+
+  if (!g_str_equal (name, SW_SERVICE_NAME))
+    return;
+
+  had_owner = (old_owner && old_owner[0] != '\0');
+  has_owner = (new_owner && new_owner[0] != '\0');
+
+  /* Only an instance that went away after giving us a view counts as a
+   * restart, the activation caused by our own open does not.
+   */
+  if (!priv->view)
+    return;
+
+  if (had_owner && !has_owner)
+  {
+    priv->service_lost = TRUE;
+    return;
+  }
+
+  /* Our view died with the old instance */
+  if (has_owner && (had_owner || priv->service_lost))
+  {
+    g_debug (G_STRLOC ": libsocialweb restarted, reopening the view");
+    priv->service_lost = FALSE;
+    _open_view (pane);
+  }
+}
+
 static void
 _service_status_updated_cb (SwClient *service,
                             gboolean  success,
@@ -281,6 +391,30 @@ _online_notify_cb (gboolean online, gpointer userdata)
   MpsFeedPane *pane = MPS_FEED_PANE (userdata);
   MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
 
+  if (!mps_governor_is_visible ())
+  {
+    if (priv->caps_stale)
+      mps_governor_add_avoided_wakeups (1);
+
+    priv->caps_stale = TRUE;
+    return;
+  }
+
+  sw_client_service_get_dynamic_capabilities (priv->service,
+                                              _service_get_dynamic_caps_cb,
+                                              pane);
+}
+
+static void
+_visibility_notify_cb (gboolean visible, gpointer userdata)
+{
+  MpsFeedPane *pane = MPS_FEED_PANE (userdata);
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+
+  if (!visible || !priv->caps_stale)
+    return;
+
+  priv->caps_stale = FALSE;
   sw_client_service_get_dynamic_capabilities (priv->service,
                                               _service_get_dynamic_caps_cb,
                                               pane);
@@ -292,9 +426,22 @@ mps_feed_pane_constructed (GObject *object)
   MpsFeedPane *pane = MPS_FEED_PANE (object);
   MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
   const gchar *service_name;
+  gchar *snapshot_path, *filename;
+  DBusGConnection *conn;
+  GError *error = NULL;
 
   service_name = sw_client_service_get_name (priv->service);
 
+  /* Show what we had last time while the view opens */
+  filename = g_strdup_printf ("feed-%s.snapshot", service_name);
+  snapshot_path = g_build_filename (g_get_user_cache_dir (),
+                                    "meego-panel-status",
+                                    filename,
+                                    NULL);
+  mps_view_bridge_set_snapshot_path (priv->bridge, snapshot_path);
+  g_free (snapshot_path);
+  g_free (filename);
+
   g_signal_connect (priv->service,
                     "status-updated",
                     (GCallback)_service_status_updated_cb,
@@ -307,15 +454,43 @@ mps_feed_pane_constructed (GObject *object)
                                               _service_get_dynamic_caps_cb,
                                               pane);
 
-  sw_client_service_query_open_view (priv->service,
-                                     "feed",
-                                     NULL,
-                                     _client_view_opened_cb,
-                                     g_object_ref (pane));
+  _open_view (pane);
 
+  conn = dbus_g_bus_get (DBUS_BUS_SESSION, &error);
+
+  if (conn)
+  {
+    priv->bus_proxy = dbus_g_proxy_new_for_name (conn,
+                                                 DBUS_SERVICE_DBUS,
+                                                 DBUS_PATH_DBUS,
+                                                 DBUS_INTERFACE_DBUS);
+    dbus_g_object_register_marshaller (sw_marshal_VOID__STRING_STRING_STRING,
+                                       G_TYPE_NONE,
+                                       G_TYPE_STRING,
+                                       G_TYPE_STRING,
+                                       G_TYPE_STRING,
+                                       G_TYPE_INVALID);
+    dbus_g_proxy_add_signal (priv->bus_proxy,
+                             "NameOwnerChanged",
+                             G_TYPE_STRING,
+                             G_TYPE_STRING,
+                             G_TYPE_STRING,
+                             G_TYPE_INVALID);
+    dbus_g_proxy_connect_signal (priv->bus_proxy,
+                                 "NameOwnerChanged",
+                                 (GCallback)_name_owner_changed_cb,
+                                 pane,
+                                 NULL);
+  } else {
+    g_warning (G_STRLOC ": Unable to watch for libsocialweb restarting: %s",
+               error->message);
+    g_clear_error (&error);
+  }
 
   sw_online_add_notify (_online_notify_cb,
                         object);
+  mps_governor_add_notify (_visibility_notify_cb,
+                           object);
 
   if (G_OBJECT_CLASS (mps_feed_pane_parent_class)->constructed)
   {
@@ -512,13 +687,12 @@ _card_reply_clicked (MpsTweetCard *card,
 {
   MpsFeedPane *pane = MPS_FEED_PANE (userdata);
   MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
-  SwItem *item;
+  MpsItem *item;
   gchar *reply_msg;
 
   item = mps_tweet_card_get_item (card);
 
-  reply_msg = g_strdup_printf ("@%s ",
-                               sw_item_get_value (item, "authorid"));
+  reply_msg = g_strdup_printf ("@%s ", item->authorid);
   mpl_entry_set_text (MPL_ENTRY (priv->entry), reply_msg);
   clutter_actor_grab_key_focus (priv->entry);
   g_free (reply_msg);
@@ -530,23 +704,36 @@ _card_retweet_clicked (MpsTweetCard *card,
 {
   MpsFeedPane *pane = MPS_FEED_PANE (userdata);
   MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
-  SwItem *item;
+  MpsItem *item;
   gchar *retweet_msg;
 
   item = mps_tweet_card_get_item (card);
 
   retweet_msg = g_strdup_printf ("RT @%s: %s",
-                                 sw_item_get_value (item, "authorid"),
-                                 sw_item_get_value (item, "content"));
+                                 item->authorid,
+                                 item->content);
 
   mpl_entry_set_text (MPL_ENTRY (priv->entry), retweet_msg);
   clutter_actor_grab_key_focus (priv->entry);
   g_free (retweet_msg);
 }
 
+static void
+_card_thread_toggled (MpsTweetCard *card,
+                      gboolean      expanded,
+                      gpointer      userdata)
+{
+  MpsFeedPane *pane = MPS_FEED_PANE (userdata);
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+
+  mps_view_bridge_set_thread_expanded (priv->bridge,
+                                       mps_tweet_card_get_item (card)->uuid,
+                                       expanded);
+}
+
 static ClutterActor *
 _bridge_factory_func (MpsViewBridge *bridge,
-                      SwItem        *item,
+                      MpsItem       *item,
                       gpointer       userdata)
 {
   ClutterActor *actor;
@@ -563,10 +750,54 @@ _bridge_factory_func (MpsViewBridge *bridge,
                     "retweet-clicked",
                     (GCallback)_card_retweet_clicked,
                     userdata);
+  g_signal_connect (actor,
+                    "thread-toggled",
+                    (GCallback)_card_thread_toggled,
+                    userdata);
 
   return actor;
 }
 
+/* Fetch the next older page once the last one is less than a screen away.
+ * Upper only catches up on the next allocation so wait for it before asking
+ * again, otherwise one scroll would pull in several pages.
+ */
+static void
+_feed_box_vadjustment_notify_cb (MxAdjustment *adjustment,
+                                 GParamSpec   *pspec,
+                                 MpsFeedPane  *pane)
+{
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+  gdouble value, upper, page_size;
+
+  if (!priv->bridge || priv->loading_older)
+    return;
+
+  mx_adjustment_get_values (adjustment,
+                            &value,
+                            NULL,
+                            &upper,
+                            NULL,
+                            NULL,
+                            &page_size);
+
+  if (page_size <= 0.0 || value + 2 * page_size < upper)
+    return;
+
+  if (mps_view_bridge_load_older (priv->bridge, FEED_PAGE_ITEMS) > 0)
+    priv->loading_older = TRUE;
+}
+
+static void
+_feed_box_vadjustment_upper_notify_cb (MxAdjustment *adjustment,
+                                       GParamSpec   *pspec,
+                                       MpsFeedPane  *pane)
+{
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+
+  priv->loading_older = FALSE;
+}
+
 static void
 _geotag_pane_reverse_location_notify_cb (MpsGeotagPane *geotag_pane,
                                          GParamSpec    *pspec,
@@ -581,6 +812,7 @@ mps_feed_pane_init (MpsFeedPane *self)
   MpsFeedPanePrivate *priv = GET_PRIVATE (self);
   ClutterActor *tmp_text;
   ClutterActor *entry;
+  MxAdjustment *vadjustment;
 
   /* Actor creation */
   priv->entry = (ClutterActor *) mpl_entry_new (_("Update"));
@@ -601,15 +833,17 @@ mps_feed_pane_init (MpsFeedPane *self)
 
   priv->scroll_view = mx_scroll_view_new ();
 
-  priv->box_layout = mx_box_layout_new ();
-  mx_box_layout_set_orientation (MX_BOX_LAYOUT (priv->box_layout),
-                                 MX_ORIENTATION_VERTICAL);
+  priv->feed_box = mps_feed_box_new ();
   priv->bridge = mps_view_bridge_new ();
   mps_view_bridge_set_factory_func (priv->bridge,
                                     _bridge_factory_func,
                                     self);
   mps_view_bridge_set_container (priv->bridge,
-                                 CLUTTER_CONTAINER (priv->box_layout));
+                                 MPS_FEED_BOX (priv->feed_box));
+  g_object_set (priv->bridge,
+                "max-items", FEED_MAX_ITEMS,
+                "max-age", FEED_MAX_AGE,
+                NULL);
 
   priv->something_wrong_frame = mx_frame_new ();
   priv->something_wrong_label = mx_label_new_with_text (SOMETHING_WRONG_TEXT);
@@ -704,7 +938,19 @@ mps_feed_pane_init (MpsFeedPane *self)
   clutter_actor_hide (priv->geotag_pane);
 
   clutter_container_add_actor (CLUTTER_CONTAINER (priv->scroll_view),
-                               priv->box_layout);
+                               priv->feed_box);
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->feed_box),
+                                 NULL,
+                                 &vadjustment);
+  g_signal_connect (vadjustment,
+                    "notify::value",
+                    (GCallback)_feed_box_vadjustment_notify_cb,
+                    self);
+  g_signal_connect (vadjustment,
+                    "notify::upper",
+                    (GCallback)_feed_box_vadjustment_upper_notify_cb,
+                    self);
 
   mx_bin_set_child (MX_BIN (priv->something_wrong_frame),
                     priv->something_wrong_label);
@@ -744,3 +990,11 @@ mps_feed_pane_new (SwClient        *client,
                        NULL);
 }
 
+
+MpsViewBridge *
+mps_feed_pane_get_bridge (MpsFeedPane *pane)
+{
+  MpsFeedPanePrivate *priv = GET_PRIVATE (pane);
+
+  return priv->bridge;
+}
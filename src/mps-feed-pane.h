@@ -22,6 +22,8 @@
 
 #include <mx/mx.h>
 
+#include "mps-view-bridge.h"
+
 G_BEGIN_DECLS
 
 #define MPS_TYPE_FEED_PANE mps_feed_pane_get_type()
@@ -53,6 +55,7 @@ GType mps_feed_pane_get_type (void);
 
 ClutterActor *mps_feed_pane_new (SwClient        *client,
                                  SwClientService *service);
+MpsViewBridge *mps_feed_pane_get_bridge (MpsFeedPane *pane);
 
 G_END_DECLS
 
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "mps-feed-snapshot.h"
+
+/* File layout, in host byte order:
+ *
+ *   header
+ *   item: date (gint64), then each field as a guint32 length followed by
+ *         that many bytes, 0 meaning not set
+ *   ...
+ *
+ * Fields start on a 4 byte boundary.
+ */
+#define SNAPSHOT_MAGIC "MPSFEED1"
+#define SNAPSHOT_VERSION 2
+
+#define PAD(n) (((n) + 3) & ~3)
+
+typedef struct
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 n_items;
+} MpsFeedSnapshotHeader;
+
+/* Stored after the uuid and service in this order: author, authorid,
+ * authoricon, content, url, place_full_name and in_reply_to.
+ */
+#define N_SNAPSHOT_PROPS 7
+
+static const gchar *
+_read_string (const gchar  *contents,
+              gsize         length,
+              gsize        *offset,
+              gboolean     *ok)
+{
+  guint32 len;
+  const gchar *str;
+
+  if (*offset + sizeof (guint32) > length)
+  {
+    *ok = FALSE;
+    return NULL;
+  }
+
+  memcpy (&len, contents + *offset, sizeof (guint32));
+  *offset += sizeof (guint32);
+
+  if (len == 0)
+    return NULL;
+
+  /* Stored with their nul */
+  if (*offset + len > length || contents[*offset + len - 1] != '\0')
+  {
+    *ok = FALSE;
+    return NULL;
+  }
+
+  str = contents + *offset;
+  *offset += PAD (len);
+
+  return str;
+}
+
+/* Returns the items in the snapshot, newest first, or NULL if there isn't a
+ * usable one. Free with mps_item_unref and g_list_free.
+ */
+GList *
+mps_feed_snapshot_load (const gchar *path)
+{
+  GMappedFile *mapping;
+  const MpsFeedSnapshotHeader *header;
+  const gchar *contents;
+  GList *items = NULL;
+  GError *error = NULL;
+  gsize length, offset;
+  guint i;
+
+  mapping = g_mapped_file_new (path, FALSE, &error);
+
+  if (!mapping)
+  {
+    if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+    {
+      g_warning (G_STRLOC ": Unable to map feed snapshot: %s",
+                 error->message);
+    }
+
+    g_clear_error (&error);
+    return NULL;
+  }
+
+  contents = g_mapped_file_get_contents (mapping);
+  length = g_mapped_file_get_length (mapping);
+  header = (const MpsFeedSnapshotHeader *)contents;
+
+  if (length < sizeof (MpsFeedSnapshotHeader) ||
+      memcmp (header->magic, SNAPSHOT_MAGIC, 8) != 0 ||
+      header->version != SNAPSHOT_VERSION)
+  {
+    g_mapped_file_unref (mapping);
+    return NULL;
+  }
+
+  offset = sizeof (MpsFeedSnapshotHeader);
+
+  for (i = 0; i < header->n_items; i++)
+  {
+    const gchar *uuid, *service;
+    const gchar *values[N_SNAPSHOT_PROPS];
+    gboolean ok = TRUE;
+    gint64 date;
+    gint j;
+
+    if (offset + sizeof (gint64) > length)
+      break;
+
+    memcpy (&date, contents + offset, sizeof (gint64));
+    offset += sizeof (gint64);
+
+    uuid = _read_string (contents, length, &offset, &ok);
+    service = _read_string (contents, length, &offset, &ok);
+
+    if (!ok || !uuid || !service)
+      break;
+
+    for (j = 0; j < N_SNAPSHOT_PROPS; j++)
+      values[j] = _read_string (contents, length, &offset, &ok);
+
+    if (!ok)
+      break;
+
+    /* The strings are copied out so the mapping can go */
+    items = g_list_prepend (items, mps_item_new (uuid,
+                                                 service,
+                                                 date,
+                                                 values[0],
+                                                 values[1],
+                                                 values[2],
+                                                 values[3],
+                                                 values[4],
+                                                 values[5],
+                                                 values[6]));
+  }
+
+  g_mapped_file_unref (mapping);
+
+  return g_list_reverse (items);
+}
+
+static void
+_write_string (GString     *buffer,
+               const gchar *str)
+{
+  static const gchar padding[4] = { 0, };
+  guint32 len;
+
+  len = str ? strlen (str) + 1 : 0;
+  g_string_append_len (buffer, (const gchar *)&len, sizeof (guint32));
+
+  if (len > 0)
+  {
+    g_string_append_len (buffer, str, len);
+    g_string_append_len (buffer, padding, PAD (len) - len);
+  }
+}
+
+/* Items should be newest first */
+gboolean
+mps_feed_snapshot_save (const gchar  *path,
+                        GList        *items,
+                        GError      **error)
+{
+  MpsFeedSnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, 0 };
+  GString *buffer;
+  gboolean res;
+  gchar *dir;
+  GList *l;
+
+  buffer = g_string_new (NULL);
+  header.n_items = g_list_length (items);
+  g_string_append_len (buffer, (const gchar *)&header, sizeof (header));
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item = (MpsItem *)l->data;
+    gint64 date = item->date;
+
+    g_string_append_len (buffer, (const gchar *)&date, sizeof (gint64));
+    _write_string (buffer, item->uuid);
+    _write_string (buffer, item->service);
+    _write_string (buffer, item->author);
+    _write_string (buffer, item->authorid);
+    _write_string (buffer, item->authoricon);
+    _write_string (buffer, item->content);
+    _write_string (buffer, item->url);
+    _write_string (buffer, item->place_full_name);
+    _write_string (buffer, item->in_reply_to);
+  }
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0700);
+  g_free (dir);
+
+  /* Written to one side and renamed over so a reader never sees half */
+  res = g_file_set_contents (path, buffer->str, buffer->len, error);
+
+  g_string_free (buffer, TRUE);
+
+  return res;
+}
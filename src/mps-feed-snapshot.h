@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_FEED_SNAPSHOT
+#define _MPS_FEED_SNAPSHOT
+
+#include <glib.h>
+#include "mps-item.h"
+
+G_BEGIN_DECLS
+
+/* A compact copy of the fields the cards show for a feed's recent items,
+ * so it can be put on screen at startup before libsocialweb has answered.
+ */
+GList *mps_feed_snapshot_load (const gchar *path);
+gboolean mps_feed_snapshot_save (const gchar  *path,
+                                 GList        *items,
+                                 GError      **error);
+
+G_END_DECLS
+
+#endif /* _MPS_FEED_SNAPSHOT */
@@ -24,6 +24,7 @@
 
 #include "mps-feed-switcher.h"
 #include "mps-feed-pane.h"
+#include "mps-tweet-card.h"
 
 #include "mps-module.h"
 
@@ -35,6 +36,10 @@ G_DEFINE_TYPE (MpsFeedSwitcher, mps_feed_switcher, MX_TYPE_TABLE)
 #define FIRST_RUN_MESSAGE _("When you have a web account configured, you will be able to view your feeds and manage your status here.")
 #define FIRST_RUN_IMAGE THEMEDIR "/people.png"
 
+#define ALL_FEEDS_MAX_ITEMS 200
+#define ALL_FEEDS_MAX_AGE (7 * 24 * 60 * 60) /* 1 week */
+#define ALL_FEEDS_PAGE_ITEMS 20
+
 
 typedef struct _MpsFeedSwitcherPrivate MpsFeedSwitcherPrivate;
 
@@ -54,6 +59,14 @@ struct _MpsFeedSwitcherPrivate {
   ClutterActor *add_new_service_button;
 
   MxButtonGroup *button_group;
+
+  /* Every feed pane's items merged into one timeline */
+  ClutterActor *all_scroll_view;
+  ClutterActor *all_feed_box;
+  ClutterActor *all_button;
+  MpsViewBridge *all_bridge;
+  guint n_all_sources;
+  gboolean all_loading_older;
 };
 
 
@@ -118,6 +131,12 @@ mps_feed_switcher_dispose (GObject *object)
     priv->client = NULL;
   }
 
+  if (priv->all_bridge)
+  {
+    g_object_unref (priv->all_bridge);
+    priv->all_bridge = NULL;
+  }
+
   G_OBJECT_CLASS (mps_feed_switcher_parent_class)->dispose (object);
 }
 
@@ -494,11 +513,80 @@ mps_feed_switcher_set_first_run (MpsFeedSwitcher *switcher,
   }
 }
 
+static void
+_all_card_thread_toggled (MpsTweetCard *card,
+                          gboolean      expanded,
+                          gpointer      userdata)
+{
+  MpsFeedSwitcherPrivate *priv = GET_PRIVATE (userdata);
+
+  mps_view_bridge_set_thread_expanded (priv->all_bridge,
+                                       mps_tweet_card_get_item (card)->uuid,
+                                       expanded);
+}
+
+static ClutterActor *
+_all_bridge_factory_func (MpsViewBridge *bridge,
+                          MpsItem       *item,
+                          gpointer       userdata)
+{
+  ClutterActor *actor;
+
+  actor = g_object_new (MPS_TYPE_TWEET_CARD,
+                        "item", item,
+                        NULL);
+
+  g_signal_connect (actor,
+                    "thread-toggled",
+                    (GCallback)_all_card_thread_toggled,
+                    userdata);
+
+  return actor;
+}
+
+/* Same paging as the feed panes, see _feed_box_vadjustment_notify_cb */
+static void
+_all_feed_box_vadjustment_notify_cb (MxAdjustment    *adjustment,
+                                     GParamSpec      *pspec,
+                                     MpsFeedSwitcher *switcher)
+{
+  MpsFeedSwitcherPrivate *priv = GET_PRIVATE (switcher);
+  gdouble value, upper, page_size;
+
+  if (!priv->all_bridge || priv->all_loading_older)
+    return;
+
+  mx_adjustment_get_values (adjustment,
+                            &value,
+                            NULL,
+                            &upper,
+                            NULL,
+                            NULL,
+                            &page_size);
+
+  if (page_size <= 0.0 || value + 2 * page_size < upper)
+    return;
+
+  if (mps_view_bridge_load_older (priv->all_bridge, ALL_FEEDS_PAGE_ITEMS) > 0)
+    priv->all_loading_older = TRUE;
+}
+
+static void
+_all_feed_box_vadjustment_upper_notify_cb (MxAdjustment    *adjustment,
+                                           GParamSpec      *pspec,
+                                           MpsFeedSwitcher *switcher)
+{
+  MpsFeedSwitcherPrivate *priv = GET_PRIVATE (switcher);
+
+  priv->all_loading_older = FALSE;
+}
+
 static void
 mps_feed_switcher_init (MpsFeedSwitcher *self)
 {
   MpsFeedSwitcherPrivate *priv = GET_PRIVATE (self);
   ClutterActor *tmp_text, *tmp_texture, *tmp_button, *tmp_box, *tmp_label;
+  MxAdjustment *vadjustment;
 
   priv->button_box = mx_box_layout_new ();
   mx_box_layout_set_spacing (MX_BOX_LAYOUT (priv->button_box), 8);
@@ -635,6 +723,55 @@ mps_feed_switcher_init (MpsFeedSwitcher *self)
 
   priv->button_group = mx_button_group_new ();
 
+  /* Only worth having with more than one feed to merge */
+  priv->all_scroll_view = mx_scroll_view_new ();
+  priv->all_feed_box = mps_feed_box_new ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (priv->all_scroll_view),
+                               priv->all_feed_box);
+  clutter_container_add_actor (CLUTTER_CONTAINER (priv->notebook),
+                               priv->all_scroll_view);
+
+  priv->all_bridge = mps_view_bridge_new ();
+  mps_view_bridge_set_container (priv->all_bridge,
+                                 MPS_FEED_BOX (priv->all_feed_box));
+  g_object_set (priv->all_bridge,
+                "max-items", ALL_FEEDS_MAX_ITEMS,
+                "max-age", ALL_FEEDS_MAX_AGE,
+                NULL);
+  mps_view_bridge_set_factory_func (priv->all_bridge,
+                                    _all_bridge_factory_func,
+                                    self);
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->all_feed_box),
+                                 NULL,
+                                 &vadjustment);
+  g_signal_connect (vadjustment,
+                    "notify::value",
+                    (GCallback)_all_feed_box_vadjustment_notify_cb,
+                    self);
+  g_signal_connect (vadjustment,
+                    "notify::upper",
+                    (GCallback)_all_feed_box_vadjustment_upper_notify_cb,
+                    self);
+
+  priv->all_button = mx_button_new_with_label (_("All"));
+  mx_button_set_is_toggle (MX_BUTTON (priv->all_button), TRUE);
+  mx_stylable_set_style_class (MX_STYLABLE (priv->all_button),
+                               "mps-switcher-button");
+  g_object_set_data (G_OBJECT (priv->all_button),
+                     "mps-switcher-pane",
+                     priv->all_scroll_view);
+  clutter_container_add_actor (CLUTTER_CONTAINER (priv->button_box),
+                               priv->all_button);
+  clutter_container_child_set (CLUTTER_CONTAINER (priv->button_box),
+                               priv->all_button,
+                               "expand", TRUE,
+                               NULL);
+  clutter_container_lower_child (CLUTTER_CONTAINER (priv->button_box),
+                                 priv->all_button,
+                                 NULL);
+  clutter_actor_hide (priv->all_button);
+
   g_signal_connect (priv->button_group,
                     "notify::active-button",
                     (GCallback)_button_group_active_button_changed_cb,
@@ -655,6 +792,41 @@ mps_feed_switcher_new (SwClient *client)
 }
 
 
+static void
+_update_all_feeds_button (MpsFeedSwitcher *switcher)
+{
+  MpsFeedSwitcherPrivate *priv = GET_PRIVATE (switcher);
+
+  if (priv->n_all_sources >= 2 &&
+      !CLUTTER_ACTOR_IS_VISIBLE (priv->all_button))
+  {
+    mx_button_group_add (priv->button_group, MX_BUTTON (priv->all_button));
+    clutter_actor_show (priv->all_button);
+  } else if (priv->n_all_sources < 2 &&
+             CLUTTER_ACTOR_IS_VISIBLE (priv->all_button)) {
+    const GSList *buttons;
+    gboolean was_active;
+
+    was_active = (mx_button_group_get_active_button (priv->button_group) ==
+                  MX_BUTTON (priv->all_button));
+
+    if (was_active)
+      mx_button_group_set_active_button (priv->button_group, NULL);
+
+    mx_button_group_remove (priv->button_group, MX_BUTTON (priv->all_button));
+    clutter_actor_hide (priv->all_button);
+
+    /* Move off the All page through the usual handler */
+    buttons = mx_button_group_get_buttons (priv->button_group);
+
+    if (was_active && buttons)
+    {
+      mx_button_group_set_active_button (priv->button_group,
+                                         MX_BUTTON (buttons->data));
+    }
+  }
+}
+
 static void
 mps_feed_switcher_ensure_service (MpsFeedSwitcher *switcher,
                                   SwClientService *service)
@@ -697,6 +869,15 @@ mps_feed_switcher_ensure_service (MpsFeedSwitcher *switcher,
   if (!clutter_actor_get_parent (pane))
   {
     clutter_container_add_actor (CLUTTER_CONTAINER (priv->notebook), pane);
+
+    /* Custom pane types don't necessarily have a feed to share */
+    if (MPS_IS_FEED_PANE (pane))
+    {
+      mps_view_bridge_add_source (priv->all_bridge,
+                                  mps_feed_pane_get_bridge (MPS_FEED_PANE (pane)));
+      priv->n_all_sources++;
+      _update_all_feeds_button (switcher);
+    }
   }
 
   button = g_hash_table_lookup (priv->service_to_buttons,
@@ -777,6 +958,14 @@ mps_feed_switcher_remove_service (MpsFeedSwitcher *switcher,
   {
     clutter_container_remove_actor (CLUTTER_CONTAINER (priv->notebook),
                                     pane);
+
+    if (MPS_IS_FEED_PANE (pane))
+    {
+      mps_view_bridge_remove_source (priv->all_bridge,
+                                     mps_feed_pane_get_bridge (MPS_FEED_PANE (pane)));
+      priv->n_all_sources--;
+      _update_all_feeds_button (switcher);
+    }
   }
 
   /* the first run placeholder becomes visible when no services are available */
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <gconf/gconf-client.h>
+
+#include "mps-filter.h"
+#include "mps-keyword-matcher.h"
+
+#define FILTER_GCONF_DIR "/desktop/meego/status/filter"
+#define MUTED_SERVICES_KEY "muted_services"
+#define MUTED_AUTHORS_KEY "muted_authors"
+#define MUTED_KEYWORDS_KEY "muted_keywords"
+#define MUTED_PATTERNS_KEY "muted_patterns"
+
+typedef struct {
+  MpsFilterNotify callback;
+  gpointer userdata;
+} ListenerData;
+
+typedef struct {
+  GRegex *regex;
+  const gchar *service; /* interned, NULL for every service */
+} MpsFilterPattern;
+
+typedef struct {
+  GHashTable *services;
+
+  /* "service/author", or "/author" for every service */
+  GHashTable *authors;
+
+  /* The keyword data is the interned service, NULL for every service */
+  MpsKeywordMatcher *keywords;
+  guint n_keywords;
+
+  GList *patterns;
+} MpsFilterRules;
+
+static GConfClient *gconf_client = NULL;
+static MpsFilterRules *rules = NULL;
+static guint recompile_id = 0;
+static GList *listeners = NULL;
+
+static void
+_rules_free (MpsFilterRules *old_rules)
+{
+  GList *l;
+
+  g_hash_table_destroy (old_rules->services);
+  g_hash_table_destroy (old_rules->authors);
+  mps_keyword_matcher_free (old_rules->keywords);
+
+  for (l = old_rules->patterns; l; l = l->next)
+  {
+    MpsFilterPattern *pattern = (MpsFilterPattern *)l->data;
+
+    g_regex_unref (pattern->regex);
+    g_slice_free (MpsFilterPattern, pattern);
+  }
+
+  g_list_free (old_rules->patterns);
+  g_slice_free (MpsFilterRules, old_rules);
+}
+
+static GSList *
+_get_list (const gchar *dir,
+           const gchar *name)
+{
+  GError *error = NULL;
+  GSList *values;
+  gchar *key;
+
+  key = g_strconcat (dir, "/", name, NULL);
+  values = gconf_client_get_list (gconf_client,
+                                  key,
+                                  GCONF_VALUE_STRING,
+                                  &error);
+
+  if (error)
+  {
+    g_warning (G_STRLOC ": Error reading %s: %s",
+               key,
+               error->message);
+    g_clear_error (&error);
+  }
+
+  g_free (key);
+
+  return values;
+}
+
+static void
+_free_list (GSList *values)
+{
+  g_slist_foreach (values, (GFunc)g_free, NULL);
+  g_slist_free (values);
+}
+
+/* Rules from one directory, service is NULL for the global ones */
+static void
+_compile_dir (MpsFilterRules *new_rules,
+              const gchar    *dir,
+              const gchar    *service)
+{
+  GSList *values, *l;
+
+  values = _get_list (dir, MUTED_AUTHORS_KEY);
+
+  for (l = values; l; l = l->next)
+  {
+    g_hash_table_insert (new_rules->authors,
+                         g_strconcat (service ? service : "",
+                                      "/",
+                                      (gchar *)l->data,
+                                      NULL),
+                         GINT_TO_POINTER (TRUE));
+  }
+
+  _free_list (values);
+
+  values = _get_list (dir, MUTED_KEYWORDS_KEY);
+
+  for (l = values; l; l = l->next)
+  {
+    gchar *folded = g_utf8_casefold ((gchar *)l->data, -1);
+
+    mps_keyword_matcher_add (new_rules->keywords, folded, (gpointer)service);
+    new_rules->n_keywords++;
+    g_free (folded);
+  }
+
+  _free_list (values);
+
+  values = _get_list (dir, MUTED_PATTERNS_KEY);
+
+  for (l = values; l; l = l->next)
+  {
+    MpsFilterPattern *pattern;
+    GError *error = NULL;
+    GRegex *regex;
+
+    regex = g_regex_new ((gchar *)l->data,
+                         G_REGEX_CASELESS | G_REGEX_OPTIMIZE,
+                         0,
+                         &error);
+
+    if (!regex)
+    {
+      g_warning (G_STRLOC ": Ignoring bad pattern %s: %s",
+                 (gchar *)l->data,
+                 error->message);
+      g_clear_error (&error);
+      continue;
+    }
+
+    pattern = g_slice_new (MpsFilterPattern);
+    pattern->regex = regex;
+    pattern->service = service;
+    new_rules->patterns = g_list_prepend (new_rules->patterns, pattern);
+  }
+
+  _free_list (values);
+}
+
+static MpsFilterRules *
+_compile_rules (void)
+{
+  MpsFilterRules *new_rules;
+  GSList *values, *dirs, *l;
+  GTimer *timer;
+
+  timer = g_timer_new ();
+
+  new_rules = g_slice_new0 (MpsFilterRules);
+  new_rules->services = g_hash_table_new_full (g_str_hash,
+                                               g_str_equal,
+                                               g_free,
+                                               NULL);
+  new_rules->authors = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              NULL);
+  new_rules->keywords = mps_keyword_matcher_new ();
+
+  values = _get_list (FILTER_GCONF_DIR, MUTED_SERVICES_KEY);
+
+  for (l = values; l; l = l->next)
+  {
+    g_hash_table_insert (new_rules->services,
+                         g_strdup ((gchar *)l->data),
+                         GINT_TO_POINTER (TRUE));
+  }
+
+  _free_list (values);
+
+  _compile_dir (new_rules, FILTER_GCONF_DIR, NULL);
+
+  dirs = gconf_client_all_dirs (gconf_client, FILTER_GCONF_DIR, NULL);
+
+  for (l = dirs; l; l = l->next)
+  {
+    gchar *service;
+
+    service = g_path_get_basename ((gchar *)l->data);
+    _compile_dir (new_rules, (gchar *)l->data, g_intern_string (service));
+    g_free (service);
+  }
+
+  _free_list (dirs);
+
+  mps_keyword_matcher_compile (new_rules->keywords);
+
+  g_debug (G_STRLOC ": Compiled %d services, %d authors, %d keywords and "
+           "%d patterns in %.2fms",
+           g_hash_table_size (new_rules->services),
+           g_hash_table_size (new_rules->authors),
+           new_rules->n_keywords,
+           g_list_length (new_rules->patterns),
+           g_timer_elapsed (timer, NULL) * 1000.0);
+
+  g_timer_destroy (timer);
+
+  return new_rules;
+}
+
+static gboolean
+_recompile_idle_cb (gpointer userdata)
+{
+  GList *l;
+
+  recompile_id = 0;
+
+  _rules_free (rules);
+  rules = _compile_rules ();
+
+  for (l = listeners; l; l = l->next)
+  {
+    ListenerData *data = l->data;
+    data->callback (data->userdata);
+  }
+
+  return FALSE;
+}
+
+/* Several keys tend to change together so recompile once they have */
+static void
+_gconf_filter_notify_cb (GConfClient *client,
+                         guint        cnxn_id,
+                         GConfEntry  *entry,
+                         gpointer     userdata)
+{
+  if (recompile_id == 0)
+    recompile_id = g_idle_add (_recompile_idle_cb, NULL);
+}
+
+static void
+_ensure_rules (void)
+{
+  GError *error = NULL;
+
+  if (rules)
+    return;
+
+  gconf_client = gconf_client_get_default ();
+  gconf_client_add_dir (gconf_client,
+                        FILTER_GCONF_DIR,
+                        GCONF_CLIENT_PRELOAD_RECURSIVE,
+                        &error);
+
+  if (error)
+  {
+    g_warning (G_STRLOC ": Error add directory to gconf: %s",
+               error->message);
+    g_clear_error (&error);
+  }
+
+  gconf_client_notify_add (gconf_client,
+                           FILTER_GCONF_DIR,
+                           _gconf_filter_notify_cb,
+                           NULL,
+                           NULL,
+                           &error);
+
+  if (error)
+  {
+    g_warning (G_STRLOC ": Error setting up gconf notification: %s",
+               error->message);
+    g_clear_error (&error);
+  }
+
+  rules = _compile_rules ();
+}
+
+static gboolean
+_author_is_muted (const gchar *service,
+                  const gchar *author)
+{
+  gchar *key;
+  gboolean muted;
+
+  if (!author)
+    return FALSE;
+
+  key = g_strconcat ("/", author, NULL);
+  muted = (g_hash_table_lookup (rules->authors, key) != NULL);
+  g_free (key);
+
+  if (muted || !service)
+    return muted;
+
+  key = g_strconcat (service, "/", author, NULL);
+  muted = (g_hash_table_lookup (rules->authors, key) != NULL);
+  g_free (key);
+
+  return muted;
+}
+
+static gboolean
+_applies_to (const gchar *rule_service,
+             const gchar *service)
+{
+  return (!rule_service || (service && g_str_equal (rule_service, service)));
+}
+
+static gboolean
+_keyword_match_cb (gpointer keyword_data,
+                   gpointer userdata)
+{
+  return _applies_to ((const gchar *)keyword_data, (const gchar *)userdata);
+}
+
+gboolean
+mps_filter_matches (MpsItem *item)
+{
+  GList *l;
+
+  _ensure_rules ();
+
+  if (item->service &&
+      g_hash_table_lookup (rules->services, item->service))
+  {
+    return TRUE;
+  }
+
+  if (_author_is_muted (item->service, item->authorid) ||
+      _author_is_muted (item->service, item->author))
+  {
+    return TRUE;
+  }
+
+  if (!item->content)
+    return FALSE;
+
+  if (rules->n_keywords > 0)
+  {
+    gchar *folded;
+    gboolean matched;
+
+    folded = g_utf8_casefold (item->content, -1);
+    matched = mps_keyword_matcher_match (rules->keywords,
+                                         folded,
+                                         _keyword_match_cb,
+                                         (gpointer)item->service);
+    g_free (folded);
+
+    if (matched)
+      return TRUE;
+  }
+
+  for (l = rules->patterns; l; l = l->next)
+  {
+    MpsFilterPattern *pattern = (MpsFilterPattern *)l->data;
+
+    if (_applies_to (pattern->service, item->service) &&
+        g_regex_match (pattern->regex, item->content, 0, NULL))
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+void
+mps_filter_add_notify (MpsFilterNotify callback,
+                       gpointer        userdata)
+{
+  ListenerData *data;
+
+  data = g_slice_new (ListenerData);
+  data->callback = callback;
+  data->userdata = userdata;
+
+  listeners = g_list_prepend (listeners, data);
+}
+
+void
+mps_filter_remove_notify (MpsFilterNotify callback,
+                          gpointer        userdata)
+{
+  GList *l = listeners;
+
+  while (l)
+  {
+    ListenerData *data = l->data;
+    GList *next = l->next;
+
+    if (data->callback == callback && data->userdata == userdata)
+    {
+      g_slice_free (ListenerData, data);
+      listeners = g_list_delete_link (listeners, l);
+    }
+
+    l = next;
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_FILTER
+#define _MPS_FILTER
+
+#include <glib.h>
+#include "mps-item.h"
+
+G_BEGIN_DECLS
+
+/* Mute rules kept in GConf under /desktop/meego/status/filter. Global rules
+ * live in that directory and per-service ones in a subdirectory named after
+ * the service:
+ *
+ *  muted_services  services to hide altogether, global only
+ *  muted_authors   author names or ids
+ *  muted_keywords  matched anywhere in the content, ignoring case
+ *  muted_patterns  regular expressions matched against the content
+ *
+ * The rules are compiled once and again whenever they change.
+ */
+gboolean mps_filter_matches (MpsItem *item);
+
+typedef void (*MpsFilterNotify) (gpointer userdata);
+
+void mps_filter_add_notify (MpsFilterNotify callback,
+                            gpointer        userdata);
+void mps_filter_remove_notify (MpsFilterNotify callback,
+                               gpointer        userdata);
+
+G_END_DECLS
+
+#endif /* _MPS_FILTER */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "mps-fingerprint.h"
+
+/* Anything shorter is too likely to match unrelated posts */
+#define MIN_CONTENT_LENGTH 20
+
+/* Lowercase the scheme and host, drop a leading www., the fragment and a
+ * trailing slash.
+ */
+gchar *
+mps_fingerprint_url (const gchar *url)
+{
+  const gchar *host, *path, *end;
+  GString *key;
+  gchar *tmp;
+
+  if (!url || !url[0])
+    return NULL;
+
+  host = strstr (url, "://");
+
+  if (!host)
+    return NULL;
+
+  host += 3;
+
+  if (g_ascii_strncasecmp (host, "www.", 4) == 0)
+    host += 4;
+
+  path = host + strcspn (host, "/?#");
+  end = path + strcspn (path, "#");
+
+  while (end > path && end[-1] == '/')
+    end--;
+
+  key = g_string_new ("u:");
+
+  tmp = g_ascii_strdown (url, host - url);
+  g_string_append (key, tmp);
+  g_free (tmp);
+
+  tmp = g_ascii_strdown (host, path - host);
+  g_string_append (key, tmp);
+  g_free (tmp);
+
+  g_string_append_len (key, path, end - path);
+
+  return g_string_free (key, FALSE);
+}
+
+/* Skip any "RT @name: " prefixes so retweets match what they quote */
+static const gchar *
+_skip_retweet_prefix (const gchar *content)
+{
+  const gchar *p;
+
+  for (;;)
+  {
+    while (g_ascii_isspace (*content))
+      content++;
+
+    if (strncmp (content, "RT @", 4) != 0)
+      return content;
+
+    p = content + 4;
+
+    while (g_ascii_isalnum (*p) || *p == '_')
+      p++;
+
+    if (*p == ':')
+      p++;
+
+    content = p;
+  }
+}
+
+/* Case folded with runs of whitespace collapsed, then hashed */
+gchar *
+mps_fingerprint_content (const gchar *content)
+{
+  gchar *folded, *p, *q, *checksum, *key;
+  gboolean space = FALSE;
+
+  if (!content)
+    return NULL;
+
+  folded = g_utf8_casefold (_skip_retweet_prefix (content), -1);
+
+  for (p = q = folded; *p; p++)
+  {
+    if (g_ascii_isspace (*p))
+    {
+      space = (q != folded);
+      continue;
+    }
+
+    if (space)
+    {
+      *q++ = ' ';
+      space = FALSE;
+    }
+
+    *q++ = *p;
+  }
+
+  *q = '\0';
+
+  if (g_utf8_strlen (folded, -1) < MIN_CONTENT_LENGTH)
+  {
+    g_free (folded);
+    return NULL;
+  }
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, folded, -1);
+  key = g_strconcat ("c:", checksum, NULL);
+
+  g_free (checksum);
+  g_free (folded);
+
+  return key;
+}
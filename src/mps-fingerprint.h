@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_FINGERPRINT
+#define _MPS_FINGERPRINT
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Keys under which copies of the same post compare equal, or NULL if the
+ * value is too weak to go on. Free with g_free.
+ */
+gchar *mps_fingerprint_url (const gchar *url);
+gchar *mps_fingerprint_content (const gchar *content);
+
+G_END_DECLS
+
+#endif /* _MPS_FINGERPRINT */
@@ -22,6 +22,7 @@
 #include <geoclue/geoclue-geocode.h>
 #include <geoclue/geoclue-reverse-geocode.h>
 #include "mps-geotag-pane.h"
+#include "mps-governor.h"
 
 #include <glib/gi18n.h>
 
@@ -76,6 +77,10 @@ struct _MpsGeotagPanePrivate {
   ClutterActor *dont_use_location_button;
 
   gchar *reverse_location;
+
+  /* Lookups asked for while the panel was hidden */
+  gboolean guess_pending;
+  gboolean reverse_pending;
 };
 
 static guint signals[LAST_SIGNAL] = { 0, };
@@ -125,9 +130,13 @@ mps_geotag_pane_set_property (GObject *object, guint property_id,
   }
 }
 
+static void _visibility_notify_cb (gboolean visible, gpointer userdata);
+
 static void
 mps_geotag_pane_dispose (GObject *object)
 {
+  mps_governor_remove_notify (_visibility_notify_cb, object);
+
   G_OBJECT_CLASS (mps_geotag_pane_parent_class)->dispose (object);
 }
 
@@ -280,6 +289,16 @@ mps_geotag_pane_guess_location (MpsGeotagPane *pane)
 {
   MpsGeotagPanePrivate *priv = GET_PRIVATE (pane);
 
+  /* Nobody is going to see the answer yet */
+  if (!mps_governor_is_visible ())
+  {
+    if (priv->guess_pending)
+      mps_governor_add_avoided_wakeups (1);
+
+    priv->guess_pending = TRUE;
+    return;
+  }
+
   /* Remove existing marker */
   priv->position_set = FALSE;
   if (priv->your_location_marker)
@@ -334,6 +353,15 @@ mps_geotag_pane_reverse_point (MpsGeotagPane *pane)
   MpsGeotagPanePrivate *priv = GET_PRIVATE (pane);
   GeoclueAccuracy *accuracy;
 
+  if (!mps_governor_is_visible ())
+  {
+    if (priv->reverse_pending)
+      mps_governor_add_avoided_wakeups (1);
+
+    priv->reverse_pending = TRUE;
+    return;
+  }
+
   accuracy = geoclue_accuracy_new (GEOCLUE_ACCURACY_LEVEL_LOCALITY, 0, 0);
   geoclue_reverse_geocode_position_to_address_async (priv->geo_reverse_geocode,
                                                      priv->latitude,
@@ -345,6 +373,28 @@ mps_geotag_pane_reverse_point (MpsGeotagPane *pane)
 
 }
 
+static void
+_visibility_notify_cb (gboolean visible, gpointer userdata)
+{
+  MpsGeotagPane *pane = MPS_GEOTAG_PANE (userdata);
+  MpsGeotagPanePrivate *priv = GET_PRIVATE (pane);
+
+  if (!visible)
+    return;
+
+  if (priv->guess_pending)
+  {
+    priv->guess_pending = FALSE;
+    mps_geotag_pane_guess_location (pane);
+  }
+
+  if (priv->reverse_pending)
+  {
+    priv->reverse_pending = FALSE;
+    mps_geotag_pane_reverse_point (pane);
+  }
+}
+
 static void
 _geocode_address_to_position_cb (GeoclueGeocode        *geocode,
                                  GeocluePositionFields  fields,
@@ -559,6 +609,8 @@ mps_geotag_pane_init (MpsGeotagPane *self)
   GError *error = NULL;
   ClutterActor *entry;
 
+  mps_governor_add_notify (_visibility_notify_cb, self);
+
   priv->map_view = champlain_view_new ();
   priv->markers_layer = champlain_layer_new ();
   champlain_view_add_layer (CHAMPLAIN_VIEW (priv->map_view), priv->markers_layer);
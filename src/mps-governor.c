@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "mps-governor.h"
+
+typedef struct {
+  MpsGovernorNotify callback;
+  gpointer userdata;
+} ListenerData;
+
+struct _MpsGovernorTimer {
+  guint interval; /* seconds */
+  MpsGovernorTimerFunc func;
+  gpointer userdata;
+
+  guint source_id;
+  GTimeVal last_run;
+};
+
+static gboolean visible = TRUE;
+static GList *listeners = NULL;
+static GList *timers = NULL;
+
+static guint avoided_wakeups = 0;
+static guint hidden_avoided_wakeups = 0;
+
+static gboolean
+_timer_timeout_cb (gpointer userdata)
+{
+  MpsGovernorTimer *timer = (MpsGovernorTimer *)userdata;
+
+  g_get_current_time (&timer->last_run);
+  timer->func (timer->userdata);
+
+  return TRUE;
+}
+
+static void
+_timer_start (MpsGovernorTimer *timer)
+{
+  timer->source_id = g_timeout_add_seconds (timer->interval,
+                                            _timer_timeout_cb,
+                                            timer);
+}
+
+static void
+_timer_stop (MpsGovernorTimer *timer)
+{
+  if (timer->source_id != 0)
+  {
+    g_source_remove (timer->source_id);
+    timer->source_id = 0;
+  }
+}
+
+/* Run once if it came due while we were hidden, however many times over */
+static void
+_timer_catch_up (MpsGovernorTimer *timer)
+{
+  GTimeVal now;
+  glong missed;
+
+  g_get_current_time (&now);
+
+  missed = (now.tv_sec - timer->last_run.tv_sec) / timer->interval;
+
+  if (missed > 0)
+  {
+    hidden_avoided_wakeups += missed - 1;
+    _timer_timeout_cb (timer);
+
+    /* The function may have freed the timer */
+    if (!g_list_find (timers, timer))
+      return;
+  }
+
+  _timer_start (timer);
+}
+
+void
+mps_governor_set_visible (gboolean new_visible)
+{
+  GList *copy, *l;
+
+  new_visible = !!new_visible;
+
+  if (visible == new_visible)
+    return;
+
+  visible = new_visible;
+
+  /* Timer functions and listeners may free timers or remove listeners,
+   * theirs or anyone else's, so walk copies and skip what has gone.
+   */
+  copy = g_list_copy (timers);
+
+  for (l = copy; l; l = l->next)
+  {
+    if (!g_list_find (timers, l->data))
+      continue;
+
+    if (visible)
+      _timer_catch_up ((MpsGovernorTimer *)l->data);
+    else
+      _timer_stop ((MpsGovernorTimer *)l->data);
+  }
+
+  g_list_free (copy);
+
+  copy = g_list_copy (listeners);
+
+  for (l = copy; l; l = l->next)
+  {
+    ListenerData *data = l->data;
+
+    if (!g_list_find (listeners, data))
+      continue;
+
+    data->callback (visible, data->userdata);
+  }
+
+  g_list_free (copy);
+
+  if (visible)
+  {
+    avoided_wakeups += hidden_avoided_wakeups;
+
+    g_debug (G_STRLOC ": Avoided %d wakeups while hidden, %d in total",
+             hidden_avoided_wakeups,
+             avoided_wakeups);
+
+    hidden_avoided_wakeups = 0;
+  }
+}
+
+gboolean
+mps_governor_is_visible (void)
+{
+  return visible;
+}
+
+void
+mps_governor_add_notify (MpsGovernorNotify callback,
+                         gpointer          userdata)
+{
+  ListenerData *data;
+
+  data = g_slice_new (ListenerData);
+  data->callback = callback;
+  data->userdata = userdata;
+
+  listeners = g_list_prepend (listeners, data);
+}
+
+void
+mps_governor_remove_notify (MpsGovernorNotify callback,
+                            gpointer          userdata)
+{
+  GList *l = listeners;
+
+  while (l)
+  {
+    ListenerData *data = l->data;
+    GList *next = l->next;
+
+    if (data->callback == callback && data->userdata == userdata)
+    {
+      g_slice_free (ListenerData, data);
+      listeners = g_list_delete_link (listeners, l);
+    }
+
+    l = next;
+  }
+}
+
+void
+mps_governor_add_avoided_wakeups (guint n_wakeups)
+{
+  if (visible)
+    avoided_wakeups += n_wakeups;
+  else
+    hidden_avoided_wakeups += n_wakeups;
+}
+
+guint
+mps_governor_get_avoided_wakeups (void)
+{
+  return avoided_wakeups + hidden_avoided_wakeups;
+}
+
+MpsGovernorTimer *
+mps_governor_timer_new (guint                interval,
+                        MpsGovernorTimerFunc func,
+                        gpointer             userdata)
+{
+  MpsGovernorTimer *timer;
+
+  g_return_val_if_fail (interval > 0, NULL);
+
+  timer = g_slice_new0 (MpsGovernorTimer);
+  timer->interval = interval;
+  timer->func = func;
+  timer->userdata = userdata;
+  g_get_current_time (&timer->last_run);
+
+  if (visible)
+    _timer_start (timer);
+
+  timers = g_list_prepend (timers, timer);
+
+  return timer;
+}
+
+void
+mps_governor_timer_free (MpsGovernorTimer *timer)
+{
+  _timer_stop (timer);
+  timers = g_list_remove (timers, timer);
+  g_slice_free (MpsGovernorTimer, timer);
+}
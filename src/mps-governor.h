@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_GOVERNOR
+#define _MPS_GOVERNOR
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Tracks whether the panel is on screen so that work nobody would see can
+ * wait until it is. Reports visible until told otherwise, which is what the
+ * standalone window wants; as a panel we are marked hidden at setup until
+ * the toolbar first shows us.
+ */
+void mps_governor_set_visible (gboolean visible);
+gboolean mps_governor_is_visible (void);
+
+typedef void (*MpsGovernorNotify) (gboolean visible, gpointer userdata);
+
+void mps_governor_add_notify (MpsGovernorNotify callback,
+                              gpointer          userdata);
+void mps_governor_remove_notify (MpsGovernorNotify callback,
+                                 gpointer          userdata);
+
+/* For subsystems that skip or defer work themselves */
+void mps_governor_add_avoided_wakeups (guint n_wakeups);
+guint mps_governor_get_avoided_wakeups (void);
+
+/* A periodic timer that is stopped while the panel is hidden and, if it
+ * would have fired in the meantime, runs once when it is shown again.
+ */
+typedef struct _MpsGovernorTimer MpsGovernorTimer;
+typedef void (*MpsGovernorTimerFunc) (gpointer userdata);
+
+MpsGovernorTimer *mps_governor_timer_new (guint                interval,
+                                          MpsGovernorTimerFunc func,
+                                          gpointer             userdata);
+void mps_governor_timer_free (MpsGovernorTimer *timer);
+
+G_END_DECLS
+
+#endif /* _MPS_GOVERNOR */
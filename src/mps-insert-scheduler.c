@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include <clutter/clutter.h>
+
+#include "mps-insert-scheduler.h"
+
+struct _MpsInsertScheduler {
+  ClutterTimeline *timeline;
+  guint duration;
+
+  /* The running entry is at the front. Once full the oldest waiting entry
+   * gets finished early so bursts never queue up more than this.
+   */
+  gpointer *pending;
+  guint n_pending;
+  guint max_pending;
+
+  MpsInsertSchedulerFunc func;
+  gpointer userdata;
+};
+
+static void
+_drop_entry (MpsInsertScheduler *scheduler,
+             guint               i)
+{
+  scheduler->n_pending--;
+  memmove (&scheduler->pending[i],
+           &scheduler->pending[i + 1],
+           (scheduler->n_pending - i) * sizeof (gpointer));
+}
+
+static void
+_start_next (MpsInsertScheduler *scheduler)
+{
+  if (scheduler->n_pending == 0)
+    return;
+
+  clutter_timeline_rewind (scheduler->timeline);
+  clutter_timeline_start (scheduler->timeline);
+}
+
+static void
+_timeline_new_frame_cb (ClutterTimeline    *timeline,
+                        gint                msecs,
+                        MpsInsertScheduler *scheduler)
+{
+  if (scheduler->n_pending == 0)
+    return;
+
+  /* The final frame is delivered by completed */
+  if (msecs < scheduler->duration)
+    scheduler->func (scheduler->pending[0], msecs, scheduler->userdata);
+}
+
+static void
+_timeline_completed_cb (ClutterTimeline    *timeline,
+                        MpsInsertScheduler *scheduler)
+{
+  gpointer entry;
+
+  if (scheduler->n_pending == 0)
+    return;
+
+  entry = scheduler->pending[0];
+  _drop_entry (scheduler, 0);
+
+  scheduler->func (entry, scheduler->duration, scheduler->userdata);
+
+  _start_next (scheduler);
+}
+
+MpsInsertScheduler *
+mps_insert_scheduler_new (guint                  duration,
+                          guint                  max_pending,
+                          MpsInsertSchedulerFunc func,
+                          gpointer               userdata)
+{
+  MpsInsertScheduler *scheduler;
+
+  g_return_val_if_fail (max_pending > 0, NULL);
+
+  scheduler = g_slice_new0 (MpsInsertScheduler);
+  scheduler->duration = duration;
+  scheduler->max_pending = max_pending;
+  scheduler->pending = g_new0 (gpointer, max_pending);
+  scheduler->func = func;
+  scheduler->userdata = userdata;
+
+  scheduler->timeline = clutter_timeline_new (duration);
+  g_signal_connect (scheduler->timeline,
+                    "new-frame",
+                    (GCallback)_timeline_new_frame_cb,
+                    scheduler);
+  g_signal_connect (scheduler->timeline,
+                    "completed",
+                    (GCallback)_timeline_completed_cb,
+                    scheduler);
+
+  return scheduler;
+}
+
+/* Pending entries are dropped without being finished */
+void
+mps_insert_scheduler_free (MpsInsertScheduler *scheduler)
+{
+  clutter_timeline_stop (scheduler->timeline);
+  g_signal_handlers_disconnect_by_func (scheduler->timeline,
+                                        _timeline_new_frame_cb,
+                                        scheduler);
+  g_signal_handlers_disconnect_by_func (scheduler->timeline,
+                                        _timeline_completed_cb,
+                                        scheduler);
+  g_object_unref (scheduler->timeline);
+
+  g_free (scheduler->pending);
+  g_slice_free (MpsInsertScheduler, scheduler);
+}
+
+void
+mps_insert_scheduler_push (MpsInsertScheduler *scheduler,
+                           gpointer            entry)
+{
+  if (scheduler->n_pending == scheduler->max_pending)
+  {
+    gpointer oldest;
+
+    /* Collapse the oldest waiting entry, or the running one if that is
+     * all we have room for.
+     */
+    if (scheduler->max_pending > 1)
+    {
+      oldest = scheduler->pending[1];
+      _drop_entry (scheduler, 1);
+    } else {
+      clutter_timeline_stop (scheduler->timeline);
+      oldest = scheduler->pending[0];
+      _drop_entry (scheduler, 0);
+    }
+
+    scheduler->func (oldest, scheduler->duration, scheduler->userdata);
+  }
+
+  scheduler->pending[scheduler->n_pending++] = entry;
+
+  if (!clutter_timeline_is_playing (scheduler->timeline))
+    _start_next (scheduler);
+}
+
+/* Forget about an entry without finishing it */
+void
+mps_insert_scheduler_remove (MpsInsertScheduler *scheduler,
+                             gpointer            entry)
+{
+  guint i;
+
+  for (i = 0; i < scheduler->n_pending; i++)
+  {
+    if (scheduler->pending[i] == entry)
+      break;
+  }
+
+  if (i == scheduler->n_pending)
+    return;
+
+  _drop_entry (scheduler, i);
+
+  if (i == 0)
+  {
+    clutter_timeline_stop (scheduler->timeline);
+    _start_next (scheduler);
+  }
+}
+
+void
+mps_insert_scheduler_finish_all (MpsInsertScheduler *scheduler)
+{
+  clutter_timeline_stop (scheduler->timeline);
+
+  while (scheduler->n_pending > 0)
+  {
+    gpointer entry = scheduler->pending[0];
+
+    _drop_entry (scheduler, 0);
+    scheduler->func (entry, scheduler->duration, scheduler->userdata);
+  }
+}
+
+guint
+mps_insert_scheduler_get_n_pending (MpsInsertScheduler *scheduler)
+{
+  return scheduler->n_pending;
+}
+
+void
+mps_insert_scheduler_foreach (MpsInsertScheduler *scheduler,
+                              GFunc               func,
+                              gpointer            userdata)
+{
+  guint i;
+
+  for (i = 0; i < scheduler->n_pending; i++)
+    func (scheduler->pending[i], userdata);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_INSERT_SCHEDULER
+#define _MPS_INSERT_SCHEDULER
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Plays insertion animations one after another from a single timeline.
+ * The func is called with the time into the running entry's animation and
+ * once more with the full duration when that entry is done.
+ */
+typedef struct _MpsInsertScheduler MpsInsertScheduler;
+
+typedef void (*MpsInsertSchedulerFunc) (gpointer entry,
+                                        guint    msecs,
+                                        gpointer userdata);
+
+MpsInsertScheduler *mps_insert_scheduler_new (guint                  duration,
+                                              guint                  max_pending,
+                                              MpsInsertSchedulerFunc func,
+                                              gpointer               userdata);
+void mps_insert_scheduler_free (MpsInsertScheduler *scheduler);
+
+void mps_insert_scheduler_push (MpsInsertScheduler *scheduler,
+                                gpointer            entry);
+void mps_insert_scheduler_remove (MpsInsertScheduler *scheduler,
+                                  gpointer            entry);
+void mps_insert_scheduler_finish_all (MpsInsertScheduler *scheduler);
+guint mps_insert_scheduler_get_n_pending (MpsInsertScheduler *scheduler);
+void mps_insert_scheduler_foreach (MpsInsertScheduler *scheduler,
+                                   GFunc               func,
+                                   gpointer            userdata);
+
+G_END_DECLS
+
+#endif /* _MPS_INSERT_SCHEDULER */
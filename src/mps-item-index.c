@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "mps-item-index.h"
+
+struct _MpsItemIndex {
+  GSequence *entries;
+  GHashTable *uuid_to_iter;
+};
+
+typedef struct
+{
+  glong date;
+  const gchar *uuid; /* NULL for a search probe */
+  MpsItem *item;
+} MpsItemIndexEntry;
+
+static void
+_entry_free (MpsItemIndexEntry *entry)
+{
+  mps_item_unref (entry->item);
+  g_slice_free (MpsItemIndexEntry, entry);
+}
+
+/* Newest first, ties broken on the uuid. A probe sorts ahead of every
+ * entry with the same date so searching with one finds the boundary.
+ */
+static gint
+_entry_compare_func (MpsItemIndexEntry *a,
+                     MpsItemIndexEntry *b,
+                     gpointer           userdata)
+{
+  if (a->date != b->date)
+    return (a->date > b->date) ? -1 : 1;
+
+  if (!a->uuid)
+    return b->uuid ? -1 : 0;
+  if (!b->uuid)
+    return 1;
+
+  return strcmp (a->uuid, b->uuid);
+}
+
+MpsItemIndex *
+mps_item_index_new (void)
+{
+  MpsItemIndex *index;
+
+  index = g_slice_new0 (MpsItemIndex);
+  index->entries = g_sequence_new ((GDestroyNotify)_entry_free);
+  /* Keyed on the uuid of the entry's item */
+  index->uuid_to_iter = g_hash_table_new (g_str_hash, g_str_equal);
+
+  return index;
+}
+
+void
+mps_item_index_free (MpsItemIndex *index)
+{
+  g_hash_table_destroy (index->uuid_to_iter);
+  g_sequence_free (index->entries);
+  g_slice_free (MpsItemIndex, index);
+}
+
+/* Returns the position the item now occupies */
+gint
+mps_item_index_insert (MpsItemIndex *index,
+                       MpsItem      *item)
+{
+  MpsItemIndexEntry *entry;
+  GSequenceIter *iter;
+
+  if (g_hash_table_lookup (index->uuid_to_iter, item->uuid))
+    return mps_item_index_update (index, item);
+
+  entry = g_slice_new0 (MpsItemIndexEntry);
+  entry->item = mps_item_ref (item);
+  entry->date = item->date;
+  entry->uuid = item->uuid;
+
+  iter = g_sequence_insert_sorted (index->entries,
+                                   entry,
+                                   (GCompareDataFunc)_entry_compare_func,
+                                   NULL);
+  g_hash_table_insert (index->uuid_to_iter, (gpointer)entry->uuid, iter);
+
+  return g_sequence_iter_get_position (iter);
+}
+
+/* Returns the position the item occupied, or -1 if it wasn't present */
+gint
+mps_item_index_remove (MpsItemIndex *index,
+                       const gchar  *uuid)
+{
+  GSequenceIter *iter;
+  gint position;
+
+  iter = g_hash_table_lookup (index->uuid_to_iter, uuid);
+
+  if (!iter)
+    return -1;
+
+  position = g_sequence_iter_get_position (iter);
+
+  g_hash_table_remove (index->uuid_to_iter, uuid);
+  g_sequence_remove (iter);
+
+  return position;
+}
+
+/* Swap in a new version of an item, re-sorting it if its date moved */
+gint
+mps_item_index_update (MpsItemIndex *index,
+                       MpsItem      *item)
+{
+  MpsItemIndexEntry *entry;
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (index->uuid_to_iter, item->uuid);
+
+  if (!iter)
+    return mps_item_index_insert (index, item);
+
+  entry = g_sequence_get (iter);
+
+  /* The key points into the old item so swap it before letting that go */
+  mps_item_ref (item);
+  g_hash_table_steal (index->uuid_to_iter, item->uuid);
+  g_hash_table_insert (index->uuid_to_iter, (gpointer)item->uuid, iter);
+  mps_item_unref (entry->item);
+  entry->item = item;
+  entry->uuid = item->uuid;
+
+  if (entry->date != item->date)
+  {
+    entry->date = item->date;
+    g_sequence_sort_changed (iter,
+                             (GCompareDataFunc)_entry_compare_func,
+                             NULL);
+  }
+
+  return g_sequence_iter_get_position (iter);
+}
+
+gint
+mps_item_index_get_position (MpsItemIndex *index,
+                             const gchar  *uuid)
+{
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (index->uuid_to_iter, uuid);
+
+  if (!iter)
+    return -1;
+
+  return g_sequence_iter_get_position (iter);
+}
+
+MpsItem *
+mps_item_index_lookup (MpsItemIndex *index,
+                       const gchar  *uuid)
+{
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (index->uuid_to_iter, uuid);
+
+  if (!iter)
+    return NULL;
+
+  return ((MpsItemIndexEntry *)g_sequence_get (iter))->item;
+}
+
+MpsItem *
+mps_item_index_get_oldest (MpsItemIndex *index)
+{
+  GSequenceIter *iter;
+
+  if (g_sequence_get_length (index->entries) == 0)
+    return NULL;
+
+  iter = g_sequence_iter_prev (g_sequence_get_end_iter (index->entries));
+
+  return ((MpsItemIndexEntry *)g_sequence_get (iter))->item;
+}
+
+guint
+mps_item_index_get_n_items (MpsItemIndex *index)
+{
+  return g_sequence_get_length (index->entries);
+}
+
+/* Everything in the index, newest first. The items are not reffed. */
+GList *
+mps_item_index_get_items (MpsItemIndex *index)
+{
+  GSequenceIter *iter;
+  GList *items = NULL;
+
+  iter = g_sequence_get_end_iter (index->entries);
+
+  while (!g_sequence_iter_is_begin (iter))
+  {
+    iter = g_sequence_iter_prev (iter);
+    items = g_list_prepend (items,
+                            ((MpsItemIndexEntry *)g_sequence_get (iter))->item);
+  }
+
+  return items;
+}
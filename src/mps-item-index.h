@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_ITEM_INDEX
+#define _MPS_ITEM_INDEX
+
+#include <glib.h>
+#include "mps-item.h"
+
+G_BEGIN_DECLS
+
+/* Items ordered newest first, keyed on (date, uuid) */
+typedef struct _MpsItemIndex MpsItemIndex;
+
+MpsItemIndex *mps_item_index_new (void);
+void mps_item_index_free (MpsItemIndex *index);
+
+gint mps_item_index_insert (MpsItemIndex *index,
+                            MpsItem      *item);
+gint mps_item_index_remove (MpsItemIndex *index,
+                            const gchar  *uuid);
+gint mps_item_index_update (MpsItemIndex *index,
+                            MpsItem      *item);
+
+gint mps_item_index_get_position (MpsItemIndex *index,
+                                  const gchar  *uuid);
+MpsItem *mps_item_index_lookup (MpsItemIndex *index,
+                                const gchar  *uuid);
+MpsItem *mps_item_index_get_oldest (MpsItemIndex *index);
+guint mps_item_index_get_n_items (MpsItemIndex *index);
+
+GList *mps_item_index_get_items (MpsItemIndex *index);
+
+G_END_DECLS
+
+#endif /* _MPS_ITEM_INDEX */
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "mps-item.h"
+
+/* Shared strings and how many fields point at each, the table doesn't own
+ * the keys so they can be reinserted with a new count.
+ */
+static GHashTable *strings = NULL;
+
+static const gchar *
+_string_ref (const gchar *str)
+{
+  gpointer key, value;
+
+  if (!str)
+    return NULL;
+
+  if (!strings)
+    strings = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_lookup_extended (strings, str, &key, &value))
+  {
+    g_hash_table_insert (strings,
+                         key,
+                         GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+    return key;
+  }
+
+  key = g_strdup (str);
+  g_hash_table_insert (strings, key, GUINT_TO_POINTER (1));
+
+  return key;
+}
+
+static void
+_string_unref (const gchar *str)
+{
+  guint count;
+
+  if (!str)
+    return;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (strings, str));
+
+  if (count > 1)
+  {
+    g_hash_table_insert (strings, (gpointer)str, GUINT_TO_POINTER (count - 1));
+  } else {
+    g_hash_table_remove (strings, str);
+    g_free ((gchar *)str);
+  }
+}
+
+static gchar *
+_copy_inline (gchar       **dest,
+              const gchar  *str)
+{
+  gchar *start = *dest;
+  gsize len;
+
+  if (!str)
+    return NULL;
+
+  len = strlen (str) + 1;
+  memcpy (start, str, len);
+  *dest += len;
+
+  return start;
+}
+
+MpsItem *
+mps_item_new (const gchar *uuid,
+              const gchar *service,
+              glong        date,
+              const gchar *author,
+              const gchar *authorid,
+              const gchar *authoricon,
+              const gchar *content,
+              const gchar *url,
+              const gchar *place_full_name,
+              const gchar *in_reply_to)
+{
+  MpsItem *item;
+  gchar *tail;
+  gsize size;
+
+  g_return_val_if_fail (uuid, NULL);
+
+  size = sizeof (MpsItem) + strlen (uuid) + 1;
+  if (content)
+    size += strlen (content) + 1;
+  if (url)
+    size += strlen (url) + 1;
+  if (in_reply_to)
+    size += strlen (in_reply_to) + 1;
+
+  item = g_malloc (size);
+  tail = (gchar *)(item + 1);
+
+  item->refcount = 1;
+  item->date = date;
+  item->uuid = _copy_inline (&tail, uuid);
+  item->content = _copy_inline (&tail, content);
+  item->url = _copy_inline (&tail, url);
+  item->in_reply_to = _copy_inline (&tail, in_reply_to);
+
+  item->service = _string_ref (service);
+  item->author = _string_ref (author);
+  item->authorid = _string_ref (authorid);
+  item->authoricon = _string_ref (authoricon);
+  item->place_full_name = _string_ref (place_full_name);
+
+  return item;
+}
+
+/* Copies what we need, the SwItem can be dropped afterwards */
+MpsItem *
+mps_item_new_from_sw_item (SwItem *item)
+{
+  return mps_item_new (item->uuid,
+                       item->service,
+                       item->date.tv_sec,
+                       sw_item_get_value (item, "author"),
+                       sw_item_get_value (item, "authorid"),
+                       sw_item_get_value (item, "authoricon"),
+                       sw_item_get_value (item, "content"),
+                       sw_item_get_value (item, "url"),
+                       sw_item_get_value (item, "place_full_name"),
+                       sw_item_get_value (item, "in_reply_to"));
+}
+
+MpsItem *
+mps_item_ref (MpsItem *item)
+{
+  g_return_val_if_fail (item, NULL);
+
+  g_atomic_int_inc (&item->refcount);
+
+  return item;
+}
+
+void
+mps_item_unref (MpsItem *item)
+{
+  g_return_if_fail (item);
+
+  if (!g_atomic_int_dec_and_test (&item->refcount))
+    return;
+
+  _string_unref (item->service);
+  _string_unref (item->author);
+  _string_unref (item->authorid);
+  _string_unref (item->authoricon);
+  _string_unref (item->place_full_name);
+
+  g_free (item);
+}
+
+/* Shared strings are the same pointer when equal so only the inline ones
+ * need comparing.
+ */
+MpsItemChange
+mps_item_diff (MpsItem *a,
+               MpsItem *b)
+{
+  MpsItemChange changes = MPS_ITEM_CHANGE_NONE;
+
+  if (!a || !b)
+    return MPS_ITEM_CHANGE_ALL;
+
+  if (a == b)
+    return MPS_ITEM_CHANGE_NONE;
+
+  if (a->date != b->date)
+    changes |= MPS_ITEM_CHANGE_DATE;
+
+  if (a->author != b->author)
+    changes |= MPS_ITEM_CHANGE_AUTHOR;
+
+  if (a->authoricon != b->authoricon)
+    changes |= MPS_ITEM_CHANGE_AUTHORICON;
+
+  if (g_strcmp0 (a->content, b->content) != 0)
+    changes |= MPS_ITEM_CHANGE_CONTENT;
+
+  if (g_strcmp0 (a->url, b->url) != 0)
+    changes |= MPS_ITEM_CHANGE_URL;
+
+  if (a->place_full_name != b->place_full_name)
+    changes |= MPS_ITEM_CHANGE_PLACE;
+
+  if (a->service != b->service ||
+      a->authorid != b->authorid ||
+      !g_str_equal (a->uuid, b->uuid) ||
+      g_strcmp0 (a->in_reply_to, b->in_reply_to) != 0)
+  {
+    changes |= MPS_ITEM_CHANGE_OTHER;
+  }
+
+  return changes;
+}
+
+gboolean
+mps_item_equal (MpsItem *a,
+                MpsItem *b)
+{
+  return mps_item_diff (a, b) == MPS_ITEM_CHANGE_NONE;
+}
+
+GType
+mps_item_get_type (void)
+{
+  static GType type = 0;
+
+  if (G_UNLIKELY (type == 0))
+  {
+    type = g_boxed_type_register_static ("MpsItem",
+                                         (GBoxedCopyFunc)mps_item_ref,
+                                         (GBoxedFreeFunc)mps_item_unref);
+  }
+
+  return type;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_ITEM
+#define _MPS_ITEM
+
+#include <glib-object.h>
+#include <libsocialweb-client/sw-item.h>
+
+G_BEGIN_DECLS
+
+#define MPS_TYPE_ITEM mps_item_get_type()
+
+/* The fields of a feed item the panel actually uses. Strings that repeat
+ * across items (service, author, authorid, authoricon and place) are shared
+ * between all the items that use them, the rest live in the same allocation
+ * as the record.
+ *
+ * Treat as read-only, a changed item is a new record.
+ */
+typedef struct {
+  volatile gint refcount;
+
+  glong date;
+  const gchar *uuid;
+  const gchar *service;
+  const gchar *author;
+  const gchar *authorid;
+  const gchar *authoricon;
+  const gchar *content;
+  const gchar *url;
+  const gchar *place_full_name;
+
+  /* uuid of the item this one replies to, if the service says */
+  const gchar *in_reply_to;
+} MpsItem;
+
+/* Which fields differ between two versions of an item */
+typedef enum {
+  MPS_ITEM_CHANGE_NONE = 0,
+  MPS_ITEM_CHANGE_DATE = 1 << 0,
+  MPS_ITEM_CHANGE_AUTHOR = 1 << 1,
+  MPS_ITEM_CHANGE_AUTHORICON = 1 << 2,
+  MPS_ITEM_CHANGE_CONTENT = 1 << 3,
+  MPS_ITEM_CHANGE_URL = 1 << 4,
+  MPS_ITEM_CHANGE_PLACE = 1 << 5,
+  MPS_ITEM_CHANGE_OTHER = 1 << 6, /* uuid, service, authorid or in_reply_to */
+  MPS_ITEM_CHANGE_ALL = (1 << 7) - 1
+} MpsItemChange;
+
+GType mps_item_get_type (void);
+
+MpsItem *mps_item_new (const gchar *uuid,
+                       const gchar *service,
+                       glong        date,
+                       const gchar *author,
+                       const gchar *authorid,
+                       const gchar *authoricon,
+                       const gchar *content,
+                       const gchar *url,
+                       const gchar *place_full_name,
+                       const gchar *in_reply_to);
+MpsItem *mps_item_new_from_sw_item (SwItem *item);
+MpsItem *mps_item_ref (MpsItem *item);
+void mps_item_unref (MpsItem *item);
+MpsItemChange mps_item_diff (MpsItem *a,
+                             MpsItem *b);
+gboolean mps_item_equal (MpsItem *a,
+                         MpsItem *b);
+
+G_END_DECLS
+
+#endif /* _MPS_ITEM */
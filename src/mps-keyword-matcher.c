@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * An Aho-Corasick automaton over the bytes of the keywords. While adding,
+ * each node keeps its children in a list; compiling works out the failure
+ * links and packs the children into one array sorted by byte.
+ */
+
+#include <string.h>
+
+#include "mps-keyword-matcher.h"
+
+typedef struct {
+  guint8 byte;
+  guint target;
+} MpsKeywordEdge;
+
+typedef struct {
+  /* Only while adding */
+  GSList *children;
+
+  /* Once compiled, into the edges array */
+  guint first_edge;
+  guint n_edges;
+
+  guint fail;
+
+  /* Nearest node along the failure links that ends a keyword, 0 if none */
+  guint output_link;
+
+  /* keyword_data of the keywords ending here */
+  GSList *outputs;
+} MpsKeywordNode;
+
+struct _MpsKeywordMatcher {
+  GArray *nodes;
+  GArray *edges;
+  gboolean compiled;
+};
+
+#define NODE(m, i) (&g_array_index ((m)->nodes, MpsKeywordNode, (i)))
+#define ROOT 0
+
+MpsKeywordMatcher *
+mps_keyword_matcher_new (void)
+{
+  MpsKeywordMatcher *matcher;
+  MpsKeywordNode root = { 0, };
+
+  matcher = g_slice_new0 (MpsKeywordMatcher);
+  matcher->nodes = g_array_new (FALSE, FALSE, sizeof (MpsKeywordNode));
+  matcher->edges = g_array_new (FALSE, FALSE, sizeof (MpsKeywordEdge));
+
+  g_array_append_val (matcher->nodes, root);
+
+  return matcher;
+}
+
+void
+mps_keyword_matcher_free (MpsKeywordMatcher *matcher)
+{
+  guint i;
+
+  for (i = 0; i < matcher->nodes->len; i++)
+  {
+    MpsKeywordNode *node = NODE (matcher, i);
+
+    g_slist_foreach (node->children, (GFunc)g_free, NULL);
+    g_slist_free (node->children);
+    g_slist_free (node->outputs);
+  }
+
+  g_array_free (matcher->nodes, TRUE);
+  g_array_free (matcher->edges, TRUE);
+  g_slice_free (MpsKeywordMatcher, matcher);
+}
+
+/* While adding */
+static guint
+_find_child (MpsKeywordMatcher *matcher,
+             guint              node,
+             guint8             byte)
+{
+  GSList *l;
+
+  for (l = NODE (matcher, node)->children; l; l = l->next)
+  {
+    MpsKeywordEdge *edge = (MpsKeywordEdge *)l->data;
+
+    if (edge->byte == byte)
+      return edge->target;
+  }
+
+  return ROOT;
+}
+
+/* Once compiled, ROOT means there is no edge */
+static guint
+_goto (MpsKeywordMatcher *matcher,
+       guint              node,
+       guint8             byte)
+{
+  MpsKeywordNode *n = NODE (matcher, node);
+  MpsKeywordEdge *edges;
+  guint lo, hi;
+
+  edges = &g_array_index (matcher->edges, MpsKeywordEdge, n->first_edge);
+  lo = 0;
+  hi = n->n_edges;
+
+  while (lo < hi)
+  {
+    guint mid = (lo + hi) / 2;
+
+    if (edges[mid].byte == byte)
+      return edges[mid].target;
+    else if (edges[mid].byte < byte)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return ROOT;
+}
+
+void
+mps_keyword_matcher_add (MpsKeywordMatcher *matcher,
+                         const gchar       *keyword,
+                         gpointer           keyword_data)
+{
+  const guint8 *p;
+  guint node = ROOT;
+
+  g_return_if_fail (!matcher->compiled);
+
+  if (!keyword || !keyword[0])
+    return;
+
+  for (p = (const guint8 *)keyword; *p; p++)
+  {
+    guint child = _find_child (matcher, node, *p);
+
+    if (child == ROOT)
+    {
+      MpsKeywordNode new_node = { 0, };
+      MpsKeywordEdge *edge;
+
+      child = matcher->nodes->len;
+      g_array_append_val (matcher->nodes, new_node);
+
+      edge = g_new (MpsKeywordEdge, 1);
+      edge->byte = *p;
+      edge->target = child;
+      NODE (matcher, node)->children =
+        g_slist_prepend (NODE (matcher, node)->children, edge);
+    }
+
+    node = child;
+  }
+
+  NODE (matcher, node)->outputs = g_slist_prepend (NODE (matcher, node)->outputs,
+                                                   keyword_data);
+}
+
+static gint
+_edge_compare_func (gconstpointer a,
+                    gconstpointer b)
+{
+  return ((const MpsKeywordEdge *)a)->byte - ((const MpsKeywordEdge *)b)->byte;
+}
+
+void
+mps_keyword_matcher_compile (MpsKeywordMatcher *matcher)
+{
+  GQueue queue = G_QUEUE_INIT;
+  guint i;
+
+  g_return_if_fail (!matcher->compiled);
+
+  /* Pack the children */
+  for (i = 0; i < matcher->nodes->len; i++)
+  {
+    MpsKeywordNode *node = NODE (matcher, i);
+    GSList *l;
+
+    node->first_edge = matcher->edges->len;
+    node->n_edges = g_slist_length (node->children);
+
+    for (l = node->children; l; l = l->next)
+    {
+      g_array_append_vals (matcher->edges, l->data, 1);
+      g_free (l->data);
+    }
+
+    g_slist_free (node->children);
+    node->children = NULL;
+
+    g_qsort_with_data (&g_array_index (matcher->edges,
+                                       MpsKeywordEdge,
+                                       node->first_edge),
+                       node->n_edges,
+                       sizeof (MpsKeywordEdge),
+                       (GCompareDataFunc)_edge_compare_func,
+                       NULL);
+  }
+
+  /* Breadth first so a node's failure link is always done before its
+   * children need it.
+   */
+  g_queue_push_tail (&queue, GUINT_TO_POINTER (ROOT));
+
+  while (!g_queue_is_empty (&queue))
+  {
+    guint parent = GPOINTER_TO_UINT (g_queue_pop_head (&queue));
+    guint e;
+
+    for (e = 0; e < NODE (matcher, parent)->n_edges; e++)
+    {
+      MpsKeywordEdge *edge;
+      MpsKeywordNode *child;
+      guint fail;
+
+      edge = &g_array_index (matcher->edges,
+                             MpsKeywordEdge,
+                             NODE (matcher, parent)->first_edge + e);
+      child = NODE (matcher, edge->target);
+
+      if (parent == ROOT)
+      {
+        fail = ROOT;
+      } else {
+        fail = NODE (matcher, parent)->fail;
+
+        while (fail != ROOT && _goto (matcher, fail, edge->byte) == ROOT)
+          fail = NODE (matcher, fail)->fail;
+
+        fail = _goto (matcher, fail, edge->byte);
+      }
+
+      child->fail = fail;
+      child->output_link = NODE (matcher, fail)->outputs ?
+                           fail : NODE (matcher, fail)->output_link;
+
+      g_queue_push_tail (&queue, GUINT_TO_POINTER (edge->target));
+    }
+  }
+
+  matcher->compiled = TRUE;
+}
+
+/* Calls func for the data of each keyword found. Returns TRUE if func
+ * asked to stop.
+ */
+gboolean
+mps_keyword_matcher_match (MpsKeywordMatcher   *matcher,
+                           const gchar         *text,
+                           MpsKeywordMatchFunc  func,
+                           gpointer             userdata)
+{
+  const guint8 *p;
+  guint state = ROOT;
+
+  g_return_val_if_fail (matcher->compiled, FALSE);
+
+  if (!text || matcher->nodes->len == 1)
+    return FALSE;
+
+  for (p = (const guint8 *)text; *p; p++)
+  {
+    guint next, node;
+
+    while ((next = _goto (matcher, state, *p)) == ROOT && state != ROOT)
+      state = NODE (matcher, state)->fail;
+
+    state = next;
+
+    node = NODE (matcher, state)->outputs ?
+           state : NODE (matcher, state)->output_link;
+
+    while (node != ROOT)
+    {
+      GSList *l;
+
+      for (l = NODE (matcher, node)->outputs; l; l = l->next)
+      {
+        if (func (l->data, userdata))
+          return TRUE;
+      }
+
+      node = NODE (matcher, node)->output_link;
+    }
+  }
+
+  return FALSE;
+}
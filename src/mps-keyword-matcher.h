@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_KEYWORD_MATCHER
+#define _MPS_KEYWORD_MATCHER
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Finds every occurrence of a set of keywords in one pass over the text,
+ * however many keywords there are. Add the keywords, compile, then match.
+ */
+typedef struct _MpsKeywordMatcher MpsKeywordMatcher;
+
+/* Return TRUE to stop looking for further matches */
+typedef gboolean (*MpsKeywordMatchFunc) (gpointer keyword_data,
+                                         gpointer userdata);
+
+MpsKeywordMatcher *mps_keyword_matcher_new (void);
+void mps_keyword_matcher_free (MpsKeywordMatcher *matcher);
+
+void mps_keyword_matcher_add (MpsKeywordMatcher *matcher,
+                              const gchar       *keyword,
+                              gpointer           keyword_data);
+void mps_keyword_matcher_compile (MpsKeywordMatcher *matcher);
+
+gboolean mps_keyword_matcher_match (MpsKeywordMatcher   *matcher,
+                                    const gchar         *text,
+                                    MpsKeywordMatchFunc  func,
+                                    gpointer             userdata);
+
+G_END_DECLS
+
+#endif /* _MPS_KEYWORD_MATCHER */
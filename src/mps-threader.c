@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A union-find forest over the items seen, with the usual union by size and
+ * path halving so joining and looking up stay close to constant time.
+ */
+
+#include <string.h>
+
+#include "mps-threader.h"
+
+typedef struct _MpsThreadNode MpsThreadNode;
+
+struct _MpsThreadNode {
+  gchar *uuid;
+  MpsThreadNode *parent; /* NULL for the root of a set */
+  guint size;
+};
+
+typedef struct {
+  MpsThreadNode *node;
+  glong date;
+} MpsThreadPost;
+
+struct _MpsThreader {
+  MpsThreaderLinkFunc func;
+  gpointer userdata;
+
+  GHashTable *nodes;
+
+  /* "service/authorid" to the newest posts by them, newest first */
+  GHashTable *posts;
+
+  /* Replies still looking for what they answer, keyed on the parent's
+   * uuid or on "service/authorid" of whoever they mention.
+   */
+  GHashTable *waiting_for_uuid;
+  GHashTable *waiting_for_author;
+};
+
+/* Everything is forgotten past this, conversations already joined up stay
+ * that way but new replies can't join them.
+ */
+#define MAX_NODES 2000
+#define MAX_POSTS_PER_AUTHOR 20
+
+static void
+_node_free (MpsThreadNode *node)
+{
+  g_free (node->uuid);
+  g_slice_free (MpsThreadNode, node);
+}
+
+static void
+_post_list_free (GSList *posts)
+{
+  GSList *l;
+
+  for (l = posts; l; l = l->next)
+    g_slice_free (MpsThreadPost, l->data);
+
+  g_slist_free (posts);
+}
+
+MpsThreader *
+mps_threader_new (MpsThreaderLinkFunc func,
+                  gpointer            userdata)
+{
+  MpsThreader *threader;
+
+  threader = g_slice_new0 (MpsThreader);
+  threader->func = func;
+  threader->userdata = userdata;
+
+  threader->nodes = g_hash_table_new_full (g_str_hash,
+                                           g_str_equal,
+                                           NULL,
+                                           (GDestroyNotify)_node_free);
+  threader->posts = g_hash_table_new_full (g_str_hash,
+                                           g_str_equal,
+                                           g_free,
+                                           (GDestroyNotify)_post_list_free);
+  threader->waiting_for_uuid =
+    g_hash_table_new_full (g_str_hash,
+                           g_str_equal,
+                           g_free,
+                           (GDestroyNotify)_post_list_free);
+  threader->waiting_for_author =
+    g_hash_table_new_full (g_str_hash,
+                           g_str_equal,
+                           g_free,
+                           (GDestroyNotify)_post_list_free);
+
+  return threader;
+}
+
+void
+mps_threader_free (MpsThreader *threader)
+{
+  g_hash_table_destroy (threader->waiting_for_author);
+  g_hash_table_destroy (threader->waiting_for_uuid);
+  g_hash_table_destroy (threader->posts);
+  g_hash_table_destroy (threader->nodes);
+  g_slice_free (MpsThreader, threader);
+}
+
+static MpsThreadNode *
+_find_root (MpsThreadNode *node)
+{
+  while (node->parent)
+  {
+    if (node->parent->parent)
+      node->parent = node->parent->parent;
+
+    node = node->parent;
+  }
+
+  return node;
+}
+
+static void
+_union (MpsThreader   *threader,
+        MpsThreadNode *reply,
+        MpsThreadNode *parent)
+{
+  MpsThreadNode *a, *b;
+
+  a = _find_root (reply);
+  b = _find_root (parent);
+
+  if (a == b)
+    return;
+
+  if (a->size < b->size)
+  {
+    a->parent = b;
+    b->size += a->size;
+  } else {
+    b->parent = a;
+    a->size += b->size;
+  }
+
+  threader->func (reply->uuid, parent->uuid, threader->userdata);
+}
+
+/* "service/name" of whoever a reply is addressed to, or NULL */
+static gchar *
+_get_mention_key (MpsItem *item)
+{
+  const gchar *p, *start;
+  gchar *name, *key;
+
+  if (!item->content)
+    return NULL;
+
+  p = item->content;
+
+  while (g_ascii_isspace (*p))
+    p++;
+
+  if (*p != '@')
+    return NULL;
+
+  start = ++p;
+
+  while (g_ascii_isalnum (*p) || *p == '_')
+    p++;
+
+  if (p == start)
+    return NULL;
+
+  name = g_ascii_strdown (start, p - start);
+  key = g_strconcat (item->service, "/", name, NULL);
+  g_free (name);
+
+  return key;
+}
+
+static gchar *
+_get_author_key (MpsItem *item)
+{
+  gchar *name, *key;
+
+  if (!item->authorid)
+    return NULL;
+
+  name = g_ascii_strdown (item->authorid, -1);
+  key = g_strconcat (item->service, "/", name, NULL);
+  g_free (name);
+
+  return key;
+}
+
+/* Take a list out of the table to change it, put it back afterwards */
+static GSList *
+_steal_list (GHashTable  *table,
+             const gchar *key)
+{
+  gpointer orig_key, list;
+
+  if (!g_hash_table_lookup_extended (table, key, &orig_key, &list))
+    return NULL;
+
+  g_hash_table_steal (table, key);
+  g_free (orig_key);
+
+  return (GSList *)list;
+}
+
+static void
+_add_waiting (GHashTable    *table,
+              const gchar   *key,
+              MpsThreadNode *node,
+              glong          date)
+{
+  MpsThreadPost *post;
+  GSList *waiting;
+
+  post = g_slice_new (MpsThreadPost);
+  post->node = node;
+  post->date = date;
+
+  waiting = _steal_list (table, key);
+  g_hash_table_insert (table,
+                       g_strdup (key),
+                       g_slist_prepend (waiting, post));
+}
+
+/* Remember the post and answer any replies to it that came in first */
+static void
+_add_post (MpsThreader   *threader,
+           const gchar   *author_key,
+           MpsThreadNode *node,
+           glong          date)
+{
+  GSList *posts, *waiting, *l, *prev = NULL;
+  MpsThreadPost *post;
+
+  post = g_slice_new (MpsThreadPost);
+  post->node = node;
+  post->date = date;
+
+  posts = _steal_list (threader->posts, author_key);
+
+  /* Newest first, only the most recent few are worth keeping */
+  for (l = posts; l && ((MpsThreadPost *)l->data)->date > date; l = l->next)
+    prev = l;
+
+  if (prev)
+    prev->next = g_slist_prepend (l, post);
+  else
+    posts = g_slist_prepend (posts, post);
+
+  if (g_slist_length (posts) > MAX_POSTS_PER_AUTHOR)
+  {
+    l = g_slist_nth (posts, MAX_POSTS_PER_AUTHOR - 1);
+    _post_list_free (l->next);
+    l->next = NULL;
+  }
+
+  g_hash_table_insert (threader->posts, g_strdup (author_key), posts);
+
+  /* A mention answers the newest earlier post, ingestion runs newest first
+   * so the first one to turn up older than the reply is it.
+   */
+  waiting = _steal_list (threader->waiting_for_author, author_key);
+  prev = NULL;
+
+  for (l = waiting; l;)
+  {
+    MpsThreadPost *reply = (MpsThreadPost *)l->data;
+    GSList *next = l->next;
+
+    if (reply->date > date && reply->node != node)
+    {
+      _union (threader, reply->node, node);
+
+      if (prev)
+        prev->next = next;
+      else
+        waiting = next;
+
+      g_slice_free (MpsThreadPost, reply);
+      g_slist_free_1 (l);
+    } else {
+      prev = l;
+    }
+
+    l = next;
+  }
+
+  if (waiting)
+  {
+    g_hash_table_insert (threader->waiting_for_author,
+                         g_strdup (author_key),
+                         waiting);
+  }
+}
+
+static void
+_clear (MpsThreader *threader)
+{
+  g_debug (G_STRLOC ": Forgetting %d items",
+           g_hash_table_size (threader->nodes));
+
+  g_hash_table_remove_all (threader->waiting_for_author);
+  g_hash_table_remove_all (threader->waiting_for_uuid);
+  g_hash_table_remove_all (threader->posts);
+  g_hash_table_remove_all (threader->nodes);
+}
+
+void
+mps_threader_add (MpsThreader *threader,
+                  MpsItem     *item)
+{
+  MpsThreadNode *node, *parent;
+  gchar *author_key, *mention_key;
+  GSList *waiting, *l;
+
+  if (g_hash_table_lookup (threader->nodes, item->uuid))
+    return;
+
+  if (g_hash_table_size (threader->nodes) >= MAX_NODES)
+    _clear (threader);
+
+  node = g_slice_new0 (MpsThreadNode);
+  node->uuid = g_strdup (item->uuid);
+  node->size = 1;
+  g_hash_table_insert (threader->nodes, node->uuid, node);
+
+  /* Replies that named this one */
+  waiting = g_hash_table_lookup (threader->waiting_for_uuid, item->uuid);
+
+  for (l = waiting; l; l = l->next)
+    _union (threader, ((MpsThreadPost *)l->data)->node, node);
+
+  g_hash_table_remove (threader->waiting_for_uuid, item->uuid);
+
+  mention_key = _get_mention_key (item);
+  author_key = _get_author_key (item);
+
+  if (item->in_reply_to)
+  {
+    parent = g_hash_table_lookup (threader->nodes, item->in_reply_to);
+
+    if (parent)
+    {
+      _union (threader, node, parent);
+    } else {
+      _add_waiting (threader->waiting_for_uuid,
+                    item->in_reply_to,
+                    node,
+                    item->date);
+    }
+  } else if (mention_key && g_strcmp0 (mention_key, author_key) != 0) {
+    GSList *posts;
+
+    posts = g_hash_table_lookup (threader->posts, mention_key);
+
+    while (posts && ((MpsThreadPost *)posts->data)->date >= item->date)
+      posts = posts->next;
+
+    if (posts)
+    {
+      _union (threader, node, ((MpsThreadPost *)posts->data)->node);
+    } else {
+      _add_waiting (threader->waiting_for_author,
+                    mention_key,
+                    node,
+                    item->date);
+    }
+  }
+
+  if (author_key)
+    _add_post (threader, author_key, node, item->date);
+
+  g_free (mention_key);
+  g_free (author_key);
+}
+
+gboolean
+mps_threader_same_thread (MpsThreader *threader,
+                          const gchar *uuid_a,
+                          const gchar *uuid_b)
+{
+  MpsThreadNode *a, *b;
+
+  a = g_hash_table_lookup (threader->nodes, uuid_a);
+  b = g_hash_table_lookup (threader->nodes, uuid_b);
+
+  if (!a || !b)
+    return FALSE;
+
+  return _find_root (a) == _find_root (b);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_THREADER
+#define _MPS_THREADER
+
+#include <glib.h>
+#include "mps-item.h"
+
+G_BEGIN_DECLS
+
+/* Works out which items belong to the same conversation. An item joins the
+ * one it replies to, going by in_reply_to when the service gives it and
+ * otherwise by a leading @mention of someone with an earlier post. Items
+ * can arrive in any order, a reply seen before what it answers is joined
+ * up once that turns up.
+ */
+typedef struct _MpsThreader MpsThreader;
+
+/* Called when a reply joins two conversations that were separate so far */
+typedef void (*MpsThreaderLinkFunc) (const gchar *reply_uuid,
+                                     const gchar *parent_uuid,
+                                     gpointer     userdata);
+
+MpsThreader *mps_threader_new (MpsThreaderLinkFunc func,
+                               gpointer            userdata);
+void mps_threader_free (MpsThreader *threader);
+
+void mps_threader_add (MpsThreader *threader,
+                       MpsItem     *item);
+gboolean mps_threader_same_thread (MpsThreader *threader,
+                                   const gchar *uuid_a,
+                                   const gchar *uuid_b);
+
+G_END_DECLS
+
+#endif /* _MPS_THREADER */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "mps-time-wheel.h"
+
+/* An hour of one second slots. Later deadlines share a slot with earlier ones
+ * and are skipped until their own revolution comes round.
+ */
+#define WHEEL_SIZE 3600
+
+struct _MpsTimeWheel {
+  MpsTimeWheelEntry *slots[WHEEL_SIZE];
+  guint n_entries;
+
+  /* Everything up to and including this second has been processed */
+  glong last_tick;
+
+  guint timeout_id;
+  glong wake_time;
+
+  MpsTimeWheelFunc func;
+  gpointer userdata;
+};
+
+static glong
+_get_now (void)
+{
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  return now.tv_sec;
+}
+
+static void
+_unlink_entry (MpsTimeWheel      *wheel,
+               MpsTimeWheelEntry *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    wheel->slots[entry->deadline % WHEEL_SIZE] = entry->next;
+
+  if (entry->next)
+    entry->next->prev = entry->prev;
+
+  entry->next = NULL;
+  entry->prev = NULL;
+  entry->scheduled = FALSE;
+  wheel->n_entries--;
+}
+
+static gboolean _wheel_timeout_cb (gpointer userdata);
+
+static void
+_arm_timeout (MpsTimeWheel *wheel,
+              glong         wake_time)
+{
+  glong now;
+
+  if (wheel->timeout_id != 0)
+    g_source_remove (wheel->timeout_id);
+
+  now = _get_now ();
+
+  wheel->wake_time = wake_time;
+  wheel->timeout_id = g_timeout_add_seconds (MAX (wake_time - now, 0),
+                                             _wheel_timeout_cb,
+                                             wheel);
+}
+
+/* Find the next occupied slot and sleep until then */
+static void
+_rearm (MpsTimeWheel *wheel)
+{
+  glong t;
+
+  if (wheel->timeout_id != 0)
+  {
+    g_source_remove (wheel->timeout_id);
+    wheel->timeout_id = 0;
+  }
+
+  if (wheel->n_entries == 0)
+    return;
+
+  for (t = wheel->last_tick + 1; t <= wheel->last_tick + WHEEL_SIZE; t++)
+  {
+    if (wheel->slots[t % WHEEL_SIZE])
+    {
+      _arm_timeout (wheel, t);
+      return;
+    }
+  }
+}
+
+static void
+_process_slot (MpsTimeWheel *wheel,
+               glong         tick,
+               glong         now)
+{
+  MpsTimeWheelEntry *entry, *next;
+
+  for (entry = wheel->slots[tick % WHEEL_SIZE]; entry; entry = next)
+  {
+    next = entry->next;
+
+    /* Not due until a later revolution */
+    if (entry->deadline > now)
+      continue;
+
+    _unlink_entry (wheel, entry);
+
+    /* This may reschedule the entry, possibly into this very slot, but with
+     * a deadline in the future so it will be skipped.
+     */
+    wheel->func (entry, wheel->userdata);
+
+    /* The func may have unlinked our next entry */
+    next = wheel->slots[tick % WHEEL_SIZE];
+  }
+}
+
+static gboolean
+_wheel_timeout_cb (gpointer userdata)
+{
+  MpsTimeWheel *wheel = (MpsTimeWheel *)userdata;
+  glong now, tick, first;
+
+  wheel->timeout_id = 0;
+  now = _get_now ();
+
+  /* Timeouts in seconds are coalesced so we may have slipped a little */
+  first = MAX (wheel->last_tick + 1, now - WHEEL_SIZE + 1);
+
+  /* Anything rescheduled from the func lands after now */
+  wheel->last_tick = MAX (wheel->last_tick, now);
+
+  for (tick = first; tick <= now; tick++)
+    _process_slot (wheel, tick, now);
+
+  _rearm (wheel);
+
+  return FALSE;
+}
+
+MpsTimeWheel *
+mps_time_wheel_new (MpsTimeWheelFunc func,
+                    gpointer         userdata)
+{
+  MpsTimeWheel *wheel;
+
+  wheel = g_slice_new0 (MpsTimeWheel);
+  wheel->func = func;
+  wheel->userdata = userdata;
+  wheel->last_tick = _get_now ();
+
+  return wheel;
+}
+
+void
+mps_time_wheel_free (MpsTimeWheel *wheel)
+{
+  if (wheel->timeout_id != 0)
+    g_source_remove (wheel->timeout_id);
+
+  g_slice_free (MpsTimeWheel, wheel);
+}
+
+void
+mps_time_wheel_schedule (MpsTimeWheel      *wheel,
+                         MpsTimeWheelEntry *entry,
+                         glong              deadline)
+{
+  MpsTimeWheelEntry **slot;
+
+  if (entry->scheduled)
+    _unlink_entry (wheel, entry);
+
+  /* Nothing to catch up on while we were empty */
+  if (wheel->n_entries == 0)
+    wheel->last_tick = MAX (wheel->last_tick, _get_now ());
+
+  deadline = MAX (deadline, wheel->last_tick + 1);
+
+  slot = &wheel->slots[deadline % WHEEL_SIZE];
+
+  entry->deadline = deadline;
+  entry->prev = NULL;
+  entry->next = *slot;
+
+  if (*slot)
+    (*slot)->prev = entry;
+
+  *slot = entry;
+  entry->scheduled = TRUE;
+  wheel->n_entries++;
+
+  if (wheel->timeout_id == 0 || deadline < wheel->wake_time)
+    _arm_timeout (wheel, deadline);
+}
+
+void
+mps_time_wheel_cancel (MpsTimeWheel      *wheel,
+                       MpsTimeWheelEntry *entry)
+{
+  if (!entry->scheduled)
+    return;
+
+  _unlink_entry (wheel, entry);
+
+  if (wheel->n_entries == 0 && wheel->timeout_id != 0)
+  {
+    g_source_remove (wheel->timeout_id);
+    wheel->timeout_id = 0;
+  }
+}
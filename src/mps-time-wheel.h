@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * Author: Rob Bradford <rob@linux.intel.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _MPS_TIME_WHEEL
+#define _MPS_TIME_WHEEL
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A hashed timing wheel with a one second tick. Entries are embedded in the
+ * caller's own structures so scheduling allocates nothing, and the wheel only
+ * wakes up when the next occupied slot comes round.
+ */
+typedef struct _MpsTimeWheel MpsTimeWheel;
+typedef struct _MpsTimeWheelEntry MpsTimeWheelEntry;
+
+struct _MpsTimeWheelEntry {
+  gpointer data;
+
+  /*< private >*/
+  MpsTimeWheelEntry *next;
+  MpsTimeWheelEntry *prev;
+  glong deadline;
+  gboolean scheduled;
+};
+
+typedef void (*MpsTimeWheelFunc) (MpsTimeWheelEntry *entry,
+                                  gpointer           userdata);
+
+MpsTimeWheel *mps_time_wheel_new (MpsTimeWheelFunc func,
+                                  gpointer         userdata);
+void mps_time_wheel_free (MpsTimeWheel *wheel);
+
+void mps_time_wheel_schedule (MpsTimeWheel      *wheel,
+                              MpsTimeWheelEntry *entry,
+                              glong              deadline);
+void mps_time_wheel_cancel (MpsTimeWheel      *wheel,
+                            MpsTimeWheelEntry *entry);
+
+G_END_DECLS
+
+#endif /* _MPS_TIME_WHEEL */
@@ -20,8 +20,12 @@
 #include "mps-tweet-card.h"
 #include "penge-magic-texture.h"
 #include "penge-clickable-label.h"
+#include "mps-time-wheel.h"
+#include "mps-avatar-loader.h"
+#include "mps-avatar-cache.h"
 #include <gio/gio.h>
 #include <glib/gi18n.h>
+#include <time.h>
 
 G_DEFINE_TYPE (MpsTweetCard, mps_tweet_card, MX_TYPE_WIDGET)
 
@@ -30,34 +34,64 @@ G_DEFINE_TYPE (MpsTweetCard, mps_tweet_card, MX_TYPE_WIDGET)
 #define GET_PRIVATE(o) ((MpsTweetCard *)o)->priv
 
 struct _MpsTweetCardPrivate {
-  SwItem *item;
+  MpsItem *item;
   ClutterActor *inner_table;
 
   ClutterActor *avatar_frame;
   ClutterActor *avatar;
+  MpsAvatarRequest *avatar_request;
+  gchar *avatar_path; /* the cache entry we are showing */
 
   ClutterActor *content_label;
   ClutterActor *secondary_label;
 
   ClutterActor *button_box;
+  ClutterActor *thread_button;
+
+  /* When the relative time next needs updating, only while mapped */
+  MpsTimeWheelEntry time_entry;
+
+  /* What the secondary label is currently showing */
+  gint time_bucket;
+  guint32 time_day; /* day scale strings are relative to this */
+  const gchar *time_place;
+  guint time_occurrences;
+
+  /* How many copies of this post were folded into the card */
+  guint occurrences;
+
+  /* Replies and burst posts folded into the card, and whose burst the
+   * label names
+   */
+  guint n_replies;
+  guint n_more;
+  const gchar *more_author;
 };
 
 enum
 {
   PROP_0,
-  PROP_ITEM
+  PROP_ITEM,
+  PROP_OCCURRENCES
 };
 
 enum
 {
   REPLY_CLICKED_SIGNAL,
   RETWEET_CLICKED_SIGNAL,
+  THREAD_TOGGLED_SIGNAL,
   LAST_SIGNAL
 };
 
 static guint signals[LAST_SIGNAL] = {0, };
 
 #define DEFAULT_AVATAR_PATH THEMEDIR "/avatar_icon.png"
+#define AVATAR_SIZE 48
+
+/* Shared by every card */
+static MpsTimeWheel *time_wheel = NULL;
+
+static void mps_tweet_card_set_time (MpsTweetCard *card);
 
 static void
 mps_tweet_card_get_property (GObject *object, guint property_id,
@@ -69,6 +103,9 @@ mps_tweet_card_get_property (GObject *object, guint property_id,
     case PROP_ITEM:
       g_value_set_boxed (value, mps_tweet_card_get_item (card));
       break;
+    case PROP_OCCURRENCES:
+      g_value_set_uint (value, GET_PRIVATE (card)->occurrences);
+      break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -84,6 +121,9 @@ mps_tweet_card_set_property (GObject *object, guint property_id,
     case PROP_ITEM:
       mps_tweet_card_set_item (card, g_value_get_boxed (value));
       break;
+    case PROP_OCCURRENCES:
+      mps_tweet_card_set_occurrences (card, g_value_get_uint (value));
+      break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -94,9 +134,24 @@ mps_tweet_card_dispose (GObject *object)
 {
   MpsTweetCardPrivate *priv = GET_PRIVATE (object);
 
+  mps_time_wheel_cancel (time_wheel, &(priv->time_entry));
+
+  if (priv->avatar_request)
+  {
+    mps_avatar_loader_cancel (priv->avatar_request);
+    priv->avatar_request = NULL;
+  }
+
+  if (priv->avatar_path)
+  {
+    mps_avatar_cache_release (priv->avatar_path);
+    g_free (priv->avatar_path);
+    priv->avatar_path = NULL;
+  }
+
   if (priv->item)
   {
-    sw_item_unref (priv->item);
+    mps_item_unref (priv->item);
     priv->item = NULL;
   }
 
@@ -123,6 +178,16 @@ _retweet_button_clicked_cb (MxButton     *button,
   g_signal_emit (card, signals[RETWEET_CLICKED_SIGNAL], 0);
 }
 
+static void
+_thread_button_clicked_cb (MxButton     *button,
+                           MpsTweetCard *card)
+{
+  g_signal_emit (card,
+                 signals[THREAD_TOGGLED_SIGNAL],
+                 0,
+                 mx_button_get_toggled (button));
+}
+
 static void
 mps_tweet_card_constructed (GObject *object)
 {
@@ -177,6 +242,12 @@ mps_tweet_card_map (ClutterActor *actor)
   clutter_actor_map (priv->content_label);
   clutter_actor_map (priv->secondary_label);
   clutter_actor_map (priv->button_box);
+
+  /* The time may have gone stale while we were hidden. This also schedules
+   * the next update.
+   */
+  if (priv->item)
+    mps_tweet_card_set_time (MPS_TWEET_CARD (actor));
 }
 
 static void
@@ -190,6 +261,8 @@ mps_tweet_card_unmap (ClutterActor *actor)
   clutter_actor_unmap (priv->content_label);
   clutter_actor_unmap (priv->secondary_label);
   clutter_actor_unmap (priv->button_box);
+
+  mps_time_wheel_cancel (time_wheel, &(priv->time_entry));
 }
 
 static void
@@ -300,6 +373,13 @@ mps_tweet_card_allocate (ClutterActor           *actor,
   clutter_actor_allocate (priv->content_label, &content_label_box, flags);
 }
 
+static void
+_time_wheel_cb (MpsTimeWheelEntry *entry,
+                gpointer           userdata)
+{
+  mps_tweet_card_set_time (MPS_TWEET_CARD (entry->data));
+}
+
 static void
 mps_tweet_card_class_init (MpsTweetCardClass *klass)
 {
@@ -309,6 +389,8 @@ mps_tweet_card_class_init (MpsTweetCardClass *klass)
 
   g_type_class_add_private (klass, sizeof (MpsTweetCardPrivate));
 
+  time_wheel = mps_time_wheel_new (_time_wheel_cb, NULL);
+
   object_class->get_property = mps_tweet_card_get_property;
   object_class->set_property = mps_tweet_card_set_property;
   object_class->dispose = mps_tweet_card_dispose;
@@ -326,10 +408,18 @@ mps_tweet_card_class_init (MpsTweetCardClass *klass)
   pspec = g_param_spec_boxed ("item",
                               "Item",
                               "Item",
-                              SW_TYPE_ITEM,
+                              MPS_TYPE_ITEM,
                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
   g_object_class_install_property (object_class, PROP_ITEM, pspec);
 
+  pspec = g_param_spec_uint ("occurrences",
+                             "Occurrences",
+                             "Number of copies of the post this card stands "
+                             "for",
+                             1, G_MAXUINT, 1,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_OCCURRENCES, pspec);
+
   signals[REPLY_CLICKED_SIGNAL] = g_signal_new ("reply-clicked",
                                                 MPS_TYPE_TWEET_CARD,
                                                 G_SIGNAL_RUN_FIRST,
@@ -349,6 +439,17 @@ mps_tweet_card_class_init (MpsTweetCardClass *klass)
                                                   g_cclosure_marshal_VOID__VOID,
                                                   G_TYPE_NONE,
                                                   0);
+
+  signals[THREAD_TOGGLED_SIGNAL] = g_signal_new ("thread-toggled",
+                                                 MPS_TYPE_TWEET_CARD,
+                                                 G_SIGNAL_RUN_FIRST,
+                                                 0,
+                                                 NULL,
+                                                 NULL,
+                                                 g_cclosure_marshal_VOID__BOOLEAN,
+                                                 G_TYPE_NONE,
+                                                 1,
+                                                 G_TYPE_BOOLEAN);
 }
 
 void meego_status_panel_hide (void);
@@ -362,7 +463,7 @@ _button_release_event_cb (ClutterActor *actor,
   GError *error = NULL;
   const gchar *uri;
 
-  uri = sw_item_get_value (priv->item, "url");
+  uri = priv->item->url;
 
   if (!uri)
     return TRUE;
@@ -408,13 +509,17 @@ mps_tweet_card_init (MpsTweetCard *self)
 
   self->priv = priv;
 
+  priv->time_entry.data = self;
+  priv->time_bucket = -1;
+  priv->occurrences = 1;
+
   /* Avatar frame & avatar */
   priv->avatar_frame = mx_frame_new ();
   mx_stylable_set_style_class (MX_STYLABLE (priv->avatar_frame),
                                "mps-tweet-avatar-frame");
   priv->avatar = g_object_new (PENGE_TYPE_MAGIC_TEXTURE,
                                NULL);
-  clutter_actor_set_size (priv->avatar, 48, 48);
+  clutter_actor_set_size (priv->avatar, AVATAR_SIZE, AVATAR_SIZE);
   clutter_container_add_actor (CLUTTER_CONTAINER (priv->avatar_frame),
                                priv->avatar);
   mx_bin_set_fill (MX_BIN (priv->avatar_frame), TRUE, TRUE);
@@ -452,6 +557,19 @@ mps_tweet_card_init (MpsTweetCard *self)
   clutter_actor_set_parent (priv->button_box,
                             CLUTTER_ACTOR (self));
 
+  /* Only shown once replies have been folded in */
+  priv->thread_button = mx_button_new ();
+  mx_button_set_is_toggle (MX_BUTTON (priv->thread_button), TRUE);
+  mx_stylable_set_style_class (MX_STYLABLE (priv->thread_button),
+                               "mps-tweet-card-thread-button");
+  clutter_container_add_actor (CLUTTER_CONTAINER (priv->button_box),
+                               priv->thread_button);
+  clutter_actor_hide (priv->thread_button);
+  g_signal_connect (priv->thread_button,
+                    "clicked",
+                    (GCallback)_thread_button_clicked_cb,
+                    self);
+
   clutter_actor_set_reactive (CLUTTER_ACTOR (self), TRUE);
 }
 
@@ -461,7 +579,7 @@ mps_tweet_card_new (void)
   return g_object_new (MPS_TYPE_TWEET_CARD, NULL);
 }
 
-SwItem *
+MpsItem *
 mps_tweet_card_get_item (MpsTweetCard *card)
 {
   MpsTweetCardPrivate *priv = GET_PRIVATE (card);
@@ -469,19 +587,142 @@ mps_tweet_card_get_item (MpsTweetCard *card)
   return priv->item;
 }
 
+static guint32
+_get_local_day (glong t)
+{
+  GDate date;
+
+  g_date_clear (&date, 1);
+  g_date_set_time_t (&date, (time_t)t);
+
+  return g_date_get_julian (&date);
+}
+
+static glong
+_get_next_local_midnight (glong now)
+{
+  time_t t = (time_t)now;
+  struct tm tm;
+
+  localtime_r (&t, &tm);
+  tm.tm_sec = 0;
+  tm.tm_min = 0;
+  tm.tm_hour = 0;
+  tm.tm_mday++;
+  tm.tm_isdst = -1;
+
+  return (glong)mktime (&tm);
+}
+
+/* The relative time string only changes at the next whole unit of the scale
+ * it is shown in, minutes for the first hour and hours for the first day.
+ * After that it is worded by calendar day so it changes at local midnight
+ * and the bucket is the local date of the item. Everything in the same
+ * bucket shares a string.
+ */
+static glong
+_get_time_bucket (glong  now,
+                  glong  date,
+                  gint  *bucket)
+{
+  glong age, unit;
+  gint scale;
+
+  age = MAX (now - date, 0);
+
+  if (age < 60 * 60)
+  {
+    unit = 60;
+    scale = 0;
+  } else if (age < 60 * 60 * 24) {
+    unit = 60 * 60;
+    scale = 1;
+  } else {
+    *bucket = (2 << 24) | (gint)_get_local_day (date);
+
+    return MAX (_get_next_local_midnight (now) - now, 1);
+  }
+
+  *bucket = (scale << 24) | (gint)(age / unit);
+
+  return unit - (age % unit);
+}
+
+typedef struct
+{
+  gint bucket;
+  const gchar *place; /* interned, NULL if there isn't one */
+} MpsTimeStringKey;
+
+static guint
+_time_string_key_hash (const MpsTimeStringKey *key)
+{
+  return key->bucket * 31 + g_direct_hash (key->place);
+}
+
+static gboolean
+_time_string_key_equal (const MpsTimeStringKey *a,
+                        const MpsTimeStringKey *b)
+{
+  return (a->bucket == b->bucket && a->place == b->place);
+}
+
 static void
-mps_tweet_card_set_time (MpsTweetCard *card)
+_time_string_key_free (MpsTimeStringKey *key)
 {
-  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
-  const gchar *place_fullname;
+  g_slice_free (MpsTimeStringKey, key);
+}
+
+/* Shared by every card, dropped wholesale if it ever gets too big or the
+ * local day changes under the day scale strings.
+ */
+static GHashTable *time_strings = NULL;
+static guint32 time_strings_day = 0;
+#define TIME_STRINGS_MAX 512
+
+static const gchar *
+_lookup_time_string (gint         bucket,
+                     const gchar *place,
+                     glong        date)
+{
+  MpsTimeStringKey lookup_key, *key;
   gchar *time_str;
   gchar *secondary_msg;
+  GTimeVal tv;
+  guint32 today;
 
-  time_str = mx_utils_format_time (&(priv->item->date));
+  if (!time_strings)
+  {
+    time_strings = g_hash_table_new_full ((GHashFunc)_time_string_key_hash,
+                                          (GEqualFunc)_time_string_key_equal,
+                                          (GDestroyNotify)_time_string_key_free,
+                                          g_free);
+  }
 
-  place_fullname = sw_item_get_value (priv->item, "place_full_name");
+  today = _get_local_day (time (NULL));
 
-  if (place_fullname)
+  if (today != time_strings_day)
+  {
+    g_hash_table_remove_all (time_strings);
+    time_strings_day = today;
+  }
+
+  lookup_key.bucket = bucket;
+  lookup_key.place = place;
+
+  secondary_msg = g_hash_table_lookup (time_strings, &lookup_key);
+
+  if (secondary_msg)
+    return secondary_msg;
+
+  if (g_hash_table_size (time_strings) >= TIME_STRINGS_MAX)
+    g_hash_table_remove_all (time_strings);
+
+  tv.tv_sec = date;
+  tv.tv_usec = 0;
+  time_str = mx_utils_format_time (&tv);
+
+  if (place)
   {
     /* When the tweet has a location associated with it then this string will
      * be <human readable time> from <human readable place name>
@@ -490,63 +731,311 @@ mps_tweet_card_set_time (MpsTweetCard *card)
      */
     secondary_msg = g_strdup_printf (_("%s from %s"),
                                      time_str,
-                                     place_fullname);
-    mx_label_set_text (MX_LABEL (priv->secondary_label), secondary_msg);
-    g_free (secondary_msg);
+                                     place);
+    g_free (time_str);
   } else {
-    mx_label_set_text (MX_LABEL (priv->secondary_label), time_str);
+    secondary_msg = time_str;
   }
 
-  g_free (time_str);
+  key = g_slice_new (MpsTimeStringKey);
+  *key = lookup_key;
+  g_hash_table_insert (time_strings, key, secondary_msg);
+
+  return secondary_msg;
 }
 
-void
-mps_tweet_card_set_item (MpsTweetCard *card,
-                         SwItem       *item)
+static void
+mps_tweet_card_set_time (MpsTweetCard *card)
 {
   MpsTweetCardPrivate *priv = GET_PRIVATE (card);
-  const gchar *author_icon = NULL;
-  const gchar *content = NULL;
-  const gchar *author = NULL;
-  gchar *combined_content;
+  const gchar *place_fullname, *time_str;
+  GTimeVal now;
+  glong interval;
+  gint bucket;
+  guint32 today;
+  gchar *tmp;
+
+  g_get_current_time (&now);
+
+  interval = _get_time_bucket (now.tv_sec, priv->item->date, &bucket);
+
+  if (CLUTTER_ACTOR_IS_MAPPED (card))
+  {
+    mps_time_wheel_schedule (time_wheel,
+                             &(priv->time_entry),
+                             now.tv_sec + interval);
+  }
+
+  place_fullname = priv->item->place_full_name;
+
+  if (place_fullname)
+    place_fullname = g_intern_string (place_fullname);
+
+  /* Setting the same text again would still cost a relayout */
+  today = _get_local_day (now.tv_sec);
+
+  if (bucket == priv->time_bucket &&
+      today == priv->time_day &&
+      place_fullname == priv->time_place &&
+      priv->occurrences == priv->time_occurrences)
+  {
+    return;
+  }
+
+  priv->time_bucket = bucket;
+  priv->time_day = today;
+  priv->time_place = place_fullname;
+  priv->time_occurrences = priv->occurrences;
+
+  time_str = _lookup_time_string (bucket, place_fullname, priv->item->date);
+
+  if (priv->occurrences > 1)
+  {
+    /* e.g. A couple of hours ago, seen 3 times */
+    tmp = g_strdup_printf (_("%s, seen %d times"),
+                           time_str,
+                           priv->occurrences);
+    mx_label_set_text (MX_LABEL (priv->secondary_label), tmp);
+    g_free (tmp);
+  } else {
+    mx_label_set_text (MX_LABEL (priv->secondary_label), time_str);
+  }
+}
+
+/* Takes over the cache use of the image */
+static void
+_set_avatar_image (MpsTweetCard         *card,
+                   const gchar          *path,
+                   const MpsAvatarImage *image)
+{
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+
+  clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (priv->avatar),
+                                    image->texture);
+  penge_magic_texture_set_sub_region (PENGE_MAGIC_TEXTURE (priv->avatar),
+                                      image->x,
+                                      image->y,
+                                      image->width,
+                                      image->height);
+
+  if (priv->avatar_path)
+  {
+    mps_avatar_cache_release (priv->avatar_path);
+    g_free (priv->avatar_path);
+  }
+
+  priv->avatar_path = g_strdup (path);
+}
+
+/* Decoded once and kept for every card to fall back on */
+static GdkPixbuf *
+_get_default_avatar (void)
+{
+  static GdkPixbuf *default_avatar = NULL;
+  GdkPixbuf *pixbuf;
   GError *error = NULL;
-  ClutterActor *tmp_text;
 
-  priv->item = sw_item_ref (item);
+  if (!default_avatar)
+  {
+    pixbuf = gdk_pixbuf_new_from_file (DEFAULT_AVATAR_PATH, &error);
+
+    if (!pixbuf)
+    {
+      g_critical (G_STRLOC ": Error loading default avatar: %s",
+                  error->message);
+      g_clear_error (&error);
+      return NULL;
+    }
+
+    default_avatar = mps_avatar_loader_crop_and_scale (pixbuf, AVATAR_SIZE);
+    g_object_unref (pixbuf);
+  }
+
+  return default_avatar;
+}
+
+static void
+_avatar_loaded_cb (MpsAvatarRequest *request,
+                   GdkPixbuf        *pixbuf,
+                   const GError     *error,
+                   gpointer          userdata)
+{
+  MpsTweetCard *card = MPS_TWEET_CARD (userdata);
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+  const gchar *author_icon;
+  MpsAvatarImage image;
 
-  author_icon = sw_item_get_value (item, "authoricon");
+  priv->avatar_request = NULL;
 
-  if (!author_icon)
+  if (!pixbuf)
   {
-    author_icon = DEFAULT_AVATAR_PATH;
+    g_warning (G_STRLOC ": Error loading avatar: %s",
+               error ? error->message : "unknown error");
+    return;
   }
 
-  if (!clutter_texture_set_from_file (CLUTTER_TEXTURE (priv->avatar),
-                                      author_icon,
-                                      &error))
+  author_icon = priv->item->authoricon;
+
+  if (mps_avatar_cache_add (author_icon, pixbuf, &image))
+    _set_avatar_image (card, author_icon, &image);
+}
+
+static void
+_update_avatar (MpsTweetCard *card)
+{
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+  const gchar *author_icon;
+  MpsAvatarImage image;
+
+  if (priv->avatar_request)
   {
-    g_critical (G_STRLOC ": Error setting avatar texture: %s",
-                error->message);
-    g_clear_error (&error);
+    mps_avatar_loader_cancel (priv->avatar_request);
+    priv->avatar_request = NULL;
   }
 
-  content = sw_item_get_value (item, "content");
-  author = sw_item_get_value (item, "author");
+  author_icon = priv->item->authoricon;
+
+  /* Other cards from the same author have probably loaded it already */
+  if (author_icon && mps_avatar_cache_get (author_icon, &image))
+  {
+    _set_avatar_image (card, author_icon, &image);
+  } else {
+    /* Show the default until the real one has been decoded */
+    if (mps_avatar_cache_get (DEFAULT_AVATAR_PATH, &image) ||
+        (_get_default_avatar () &&
+         mps_avatar_cache_add (DEFAULT_AVATAR_PATH,
+                               _get_default_avatar (),
+                               &image)))
+    {
+      _set_avatar_image (card, DEFAULT_AVATAR_PATH, &image);
+    }
+
+    if (author_icon)
+    {
+      priv->avatar_request = mps_avatar_loader_load (author_icon,
+                                                     AVATAR_SIZE,
+                                                     _avatar_loaded_cb,
+                                                     card);
+    }
+  }
+}
+
+static void
+_update_content (MpsTweetCard *card)
+{
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+  gchar *combined_content;
+  ClutterActor *tmp_text;
 
   combined_content = g_markup_printf_escaped("<b>%s</b> %s",
-                                             author,
-                                             content);
+                                             priv->item->author,
+                                             priv->item->content);
 
   tmp_text = mx_label_get_clutter_text (MX_LABEL (priv->content_label));
   clutter_text_set_markup (CLUTTER_TEXT (tmp_text),
                            combined_content);
   g_free (combined_content);
+}
+
+/* Cards get rebound to other items as the feed scrolls and updated when an
+ * item changes, only redo the parts that differ from what is showing.
+ */
+void
+mps_tweet_card_set_item (MpsTweetCard *card,
+                         MpsItem      *item)
+{
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+  MpsItemChange changes;
+
+  changes = mps_item_diff (priv->item, item);
+
+  mps_item_ref (item);
+
+  if (priv->item)
+    mps_item_unref (priv->item);
+
+  priv->item = item;
+
+  if (changes & MPS_ITEM_CHANGE_AUTHORICON)
+    _update_avatar (card);
+
+  if (changes & (MPS_ITEM_CHANGE_AUTHOR | MPS_ITEM_CHANGE_CONTENT))
+    _update_content (card);
 
-  mps_tweet_card_set_time (card);
+  if (changes & (MPS_ITEM_CHANGE_DATE | MPS_ITEM_CHANGE_PLACE))
+    mps_tweet_card_set_time (card);
 }
 
 void
-mps_tweet_card_refresh (MpsTweetCard *card)
+mps_tweet_card_set_occurrences (MpsTweetCard *card,
+                                guint         occurrences)
 {
-  mps_tweet_card_set_time (card);
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+
+  occurrences = MAX (occurrences, 1);
+
+  if (priv->occurrences == occurrences)
+    return;
+
+  priv->occurrences = occurrences;
+
+  if (priv->item)
+    mps_tweet_card_set_time (card);
+
+  g_object_notify (G_OBJECT (card), "occurrences");
+}
+
+void
+mps_tweet_card_set_thread (MpsTweetCard *card,
+                           guint         n_replies,
+                           guint         n_more,
+                           gboolean      expanded)
+{
+  MpsTweetCardPrivate *priv = GET_PRIVATE (card);
+  const gchar *author;
+  gchar *label, *replies, *more;
+
+  /* Setting the toggle doesn't emit clicked so won't loop back to us */
+  mx_button_set_toggled (MX_BUTTON (priv->thread_button),
+                         (n_replies > 0 || n_more > 0) && expanded);
+
+  author = priv->item ? priv->item->author : NULL;
+
+  /* Author strings are shared so a recycled card can compare pointers */
+  if (priv->n_replies == n_replies &&
+      priv->n_more == n_more &&
+      (n_more == 0 || priv->more_author == author))
+  {
+    return;
+  }
+
+  priv->n_replies = n_replies;
+  priv->n_more = n_more;
+  priv->more_author = author;
+
+  if (n_replies == 0 && n_more == 0)
+  {
+    clutter_actor_hide (priv->thread_button);
+    return;
+  }
+
+  replies = g_strdup_printf (ngettext ("%d reply", "%d replies", n_replies),
+                             n_replies);
+  more = g_strdup_printf (_("+%d more from %s"),
+                          n_more,
+                          author ? author : "");
+
+  if (n_more == 0)
+    label = g_strdup (replies);
+  else if (n_replies == 0)
+    label = g_strdup (more);
+  else
+    label = g_strdup_printf ("%s, %s", replies, more);
+
+  mx_button_set_label (MX_BUTTON (priv->thread_button), label);
+  g_free (label);
+  g_free (replies);
+  g_free (more);
+
+  clutter_actor_show (priv->thread_button);
 }
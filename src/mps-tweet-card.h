@@ -22,7 +22,7 @@
 
 #include <glib-object.h>
 #include <mx/mx.h>
-#include <libsocialweb-client/sw-item.h>
+#include "mps-item.h"
 
 G_BEGIN_DECLS
 
@@ -58,9 +58,14 @@ GType mps_tweet_card_get_type (void);
 
 ClutterActor *mps_tweet_card_new (void);
 void mps_tweet_card_set_item (MpsTweetCard *card,
-                              SwItem   *item);
-SwItem *mps_tweet_card_get_item (MpsTweetCard *card);
-void mps_tweet_card_refresh (MpsTweetCard *card);
+                              MpsItem      *item);
+MpsItem *mps_tweet_card_get_item (MpsTweetCard *card);
+void mps_tweet_card_set_occurrences (MpsTweetCard *card,
+                                     guint         occurrences);
+void mps_tweet_card_set_thread (MpsTweetCard *card,
+                                guint         n_replies,
+                                guint         n_more,
+                                gboolean      expanded);
 
 G_END_DECLS
 
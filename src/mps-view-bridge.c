@@ -19,6 +19,12 @@
 
 #include "mps-view-bridge.h"
 #include "mps-tweet-card.h"
+#include "mps-item-index.h"
+#include "mps-feed-snapshot.h"
+#include "mps-governor.h"
+#include "mps-fingerprint.h"
+#include "mps-filter.h"
+#include "mps-threader.h"
 
 G_DEFINE_TYPE (MpsViewBridge, mps_view_bridge, G_TYPE_OBJECT)
 
@@ -29,32 +35,158 @@ typedef struct _MpsViewBridgePrivate MpsViewBridgePrivate;
 
 struct _MpsViewBridgePrivate {
   SwClientItemView *view;
-  ClutterContainer *container;
+  MpsFeedBox *container;
 
-  GHashTable *item_uid_to_actor;
-  ClutterScore *score;
-
-  GList *actors_to_animate;
-  ClutterTimeline *current_timeline;
+  /* What is in the container, newest first */
+  MpsItemIndex *index;
 
   MpsViewBridgeFactoryFunc func;
   gpointer userdata;
 
-  guint refresh_id;
+  MpsGovernorTimer *refresh_timer;
+
+  /* Retention window, 0 means no limit */
+  guint max_items;
+  guint max_age;
+
+  /* Items waiting to be inserted, newest first */
+  GList *pending;
+  guint n_pending;
+  guint ingest_id;
+  GTimer *chunk_timer;
+  gdouble last_chunk_time;
+
+  gchar *snapshot_path;
+  guint save_id;
+
+  /* Items on show, from the snapshot or an earlier view, that the current
+   * view has not delivered yet.
+   */
+  GHashTable *unconfirmed_uuids;
+  guint reconcile_id;
+
+  /* While the container is hidden changes are collected here, uuid to the
+   * latest item or NULL if it went away, and applied in one go on show.
+   */
+  GHashTable *journal;
+
+  /* Other bridges whose items we follow */
+  GList *sources;
+
+  /* Items that fell outside the retention window, kept in the snapshot so
+   * older pages can be served without going back to the service.
+   */
+  MpsItemIndex *archive;
+
+  /* Set once older pages have been loaded, retention leaves them be until
+   * the container is next hidden.
+   */
+  gboolean paged;
+
+  /* Copies of the same post, the rest of a conversation and bursts from
+   * one author are shown on one card. Groups are keyed on the uuid of the
+   * item on show and can be found by either fingerprint, the folded items
+   * are kept against their own uuid.
+   */
+  GHashTable *groups;
+  GHashTable *key_to_group;
+  GHashTable *folded_to_group;
+  MpsThreader *threader;
+
+  /* Once an author has burst_threshold posts within burst_window seconds
+   * of each other they share a card, 0 turns it off. Recent posts are kept
+   * per author, newest first.
+   */
+  guint burst_window;
+  guint burst_threshold;
+  GHashTable *author_posts;
+
+  /* Items the mute rules hide, uuid to item, in case the rules change */
+  GHashTable *filtered;
 };
 
+typedef struct
+{
+  MpsItem *item;
+  gboolean animate;
+} MpsPendingItem;
+
+typedef enum
+{
+  HIDDEN_REPLIES,
+  HIDDEN_BURST,
+  N_HIDDEN
+} MpsHiddenKind;
+
+typedef struct
+{
+  gchar *uuid;
+  gchar *keys[2];
+  GList *duplicates;
+
+  /* Items behind the card's toggle, newest first: the rest of the
+   * conversation and the author's other posts from a burst. When expanded
+   * they are in the index and get rows of their own.
+   */
+  GList *hidden[N_HIDDEN];
+  gboolean expanded;
+} MpsItemGroup;
+
+typedef struct
+{
+  gchar *uuid;
+  glong date;
+} MpsAuthorPost;
+
 enum
 {
   PROP_0,
   PROP_VIEW,
-  PROP_CONTAINER
+  PROP_CONTAINER,
+  PROP_MAX_ITEMS,
+  PROP_MAX_AGE,
+  PROP_QUEUE_DEPTH,
+  PROP_LAST_CHUNK_TIME,
+  PROP_BURST_WINDOW,
+  PROP_BURST_THRESHOLD
 };
 
+enum
+{
+  ITEM_ADDED_SIGNAL,
+  ITEM_CHANGED_SIGNAL,
+  ITEM_REMOVED_SIGNAL,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = {0, };
+
 #define THRESHOLD 5
-#define CARD_HEIGHT 84.0
+#define INGEST_BUDGET 5.0 /* ms of each frame we may spend inserting */
 #define REFRESH_TIME (600) /* 10 min */
-
-gboolean _view_refresh_items_cb (MpsViewBridge *bridge);
+#define SNAPSHOT_SAVE_DELAY 30 /* seconds */
+#define RECONCILE_GRACE_TIME 10 /* seconds */
+#define ARCHIVE_MAX_ITEMS 500
+#define DEFAULT_BURST_WINDOW 300 /* 5 min */
+#define DEFAULT_BURST_THRESHOLD 5
+
+static void _view_refresh_items_cb (gpointer userdata);
+static void _save_snapshot (MpsViewBridge *bridge);
+static void _container_mapped_notify_cb (GObject       *object,
+                                         GParamSpec    *pspec,
+                                         MpsViewBridge *bridge);
+static void _change_item (MpsViewBridge *bridge,
+                          MpsItem       *item);
+static void _filter_changed_cb (gpointer userdata);
+static void _thread_link_cb (const gchar *reply_uuid,
+                             const gchar *parent_uuid,
+                             gpointer     userdata);
+static gboolean _fold_into_burst (MpsViewBridge *bridge,
+                                  MpsItem       *item,
+                                  GList         *burst);
+static void _collect_burst (MpsViewBridge *bridge,
+                            const gchar   *uuid,
+                            GList         *burst);
 
 static void
 mps_view_bridge_get_property (GObject *object, guint property_id,
@@ -69,6 +201,24 @@ mps_view_bridge_get_property (GObject *object, guint property_id,
     case PROP_CONTAINER:
       g_value_set_object (value, mps_view_bridge_get_container (bridge));
       break;
+    case PROP_MAX_ITEMS:
+      g_value_set_uint (value, GET_PRIVATE (bridge)->max_items);
+      break;
+    case PROP_MAX_AGE:
+      g_value_set_uint (value, GET_PRIVATE (bridge)->max_age);
+      break;
+    case PROP_QUEUE_DEPTH:
+      g_value_set_uint (value, mps_view_bridge_get_queue_depth (bridge));
+      break;
+    case PROP_LAST_CHUNK_TIME:
+      g_value_set_double (value, GET_PRIVATE (bridge)->last_chunk_time);
+      break;
+    case PROP_BURST_WINDOW:
+      g_value_set_uint (value, GET_PRIVATE (bridge)->burst_window);
+      break;
+    case PROP_BURST_THRESHOLD:
+      g_value_set_uint (value, GET_PRIVATE (bridge)->burst_threshold);
+      break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -87,48 +237,154 @@ mps_view_bridge_set_property (GObject *object, guint property_id,
       break;
     case PROP_CONTAINER:
       mps_view_bridge_set_container (bridge,
-                                     (ClutterContainer *)g_value_get_object (value));
+                                     (MpsFeedBox *)g_value_get_object (value));
+      break;
+    case PROP_MAX_ITEMS:
+      mps_view_bridge_set_max_items (bridge, g_value_get_uint (value));
+      break;
+    case PROP_MAX_AGE:
+      mps_view_bridge_set_max_age (bridge, g_value_get_uint (value));
+      break;
+    case PROP_BURST_WINDOW:
+      mps_view_bridge_set_burst_window (bridge, g_value_get_uint (value));
+      break;
+    case PROP_BURST_THRESHOLD:
+      mps_view_bridge_set_burst_threshold (bridge, g_value_get_uint (value));
       break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
 }
 
+static void
+_pending_item_free (MpsPendingItem *pending)
+{
+  mps_item_unref (pending->item);
+  g_slice_free (MpsPendingItem, pending);
+}
+
+static void
+_item_group_free (MpsItemGroup *group)
+{
+  gint i;
+
+  g_list_foreach (group->duplicates, (GFunc)mps_item_unref, NULL);
+  g_list_free (group->duplicates);
+
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    g_list_foreach (group->hidden[i], (GFunc)mps_item_unref, NULL);
+    g_list_free (group->hidden[i]);
+  }
+
+  g_free (group->keys[0]);
+  g_free (group->keys[1]);
+  g_free (group->uuid);
+  g_slice_free (MpsItemGroup, group);
+}
+
+static void
+_author_post_free (MpsAuthorPost *post)
+{
+  g_free (post->uuid);
+  g_slice_free (MpsAuthorPost, post);
+}
+
+static void
+_author_posts_free (GQueue *posts)
+{
+  g_queue_foreach (posts, (GFunc)_author_post_free, NULL);
+  g_queue_free (posts);
+}
+
 static void
 mps_view_bridge_dispose (GObject *object)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (object);
 
-  if (priv->refresh_id != 0)
+  if (priv->refresh_timer)
+  {
+    mps_governor_timer_free (priv->refresh_timer);
+    priv->refresh_timer = NULL;
+  }
+
+  if (priv->ingest_id != 0)
   {
-    g_source_remove (priv->refresh_id);
-    priv->refresh_id = 0;
+    g_source_remove (priv->ingest_id);
+    priv->ingest_id = 0;
   }
 
-  if (priv->score)
+  if (priv->reconcile_id != 0)
   {
-    g_object_unref (priv->score);
-    priv->score = NULL;
+    g_source_remove (priv->reconcile_id);
+    priv->reconcile_id = 0;
   }
 
-  if (priv->item_uid_to_actor)
+  /* Don't lose whatever changed since the last save */
+  if (priv->save_id != 0)
   {
-    g_hash_table_unref (priv->item_uid_to_actor);
-    priv->item_uid_to_actor = NULL;
+    g_source_remove (priv->save_id);
+    priv->save_id = 0;
+    _save_snapshot (MPS_VIEW_BRIDGE (object));
   }
 
+  mps_filter_remove_notify (_filter_changed_cb, object);
+
+  while (priv->sources)
+    mps_view_bridge_remove_source ((MpsViewBridge *)object,
+                                   (MpsViewBridge *)priv->sources->data);
+
+  g_list_foreach (priv->pending, (GFunc)_pending_item_free, NULL);
+  g_list_free (priv->pending);
+  priv->pending = NULL;
+  priv->n_pending = 0;
+
   if (priv->view)
   {
     g_object_unref (priv->view);
     priv->view = NULL;
   }
 
+  if (priv->journal)
+  {
+    g_hash_table_destroy (priv->journal);
+    priv->journal = NULL;
+  }
+
+  if (priv->container)
+  {
+    g_signal_handlers_disconnect_by_func (priv->container,
+                                          _container_mapped_notify_cb,
+                                          object);
+    mps_feed_box_set_factory_func (priv->container, NULL, NULL);
+    g_object_unref (priv->container);
+    priv->container = NULL;
+  }
+
   G_OBJECT_CLASS (mps_view_bridge_parent_class)->dispose (object);
 }
 
 static void
 mps_view_bridge_finalize (GObject *object)
 {
+  MpsViewBridgePrivate *priv = GET_PRIVATE (object);
+
+  g_timer_destroy (priv->chunk_timer);
+  mps_item_index_free (priv->index);
+  mps_item_index_free (priv->archive);
+
+  g_hash_table_destroy (priv->folded_to_group);
+  g_hash_table_destroy (priv->key_to_group);
+  g_hash_table_destroy (priv->groups);
+  g_hash_table_destroy (priv->filtered);
+  mps_threader_free (priv->threader);
+  g_hash_table_destroy (priv->author_posts);
+
+  if (priv->unconfirmed_uuids)
+    g_hash_table_destroy (priv->unconfirmed_uuids);
+
+  g_free (priv->snapshot_path);
+
   G_OBJECT_CLASS (mps_view_bridge_parent_class)->finalize (object);
 }
 
@@ -136,6 +392,7 @@ static void
 mps_view_bridge_class_init (MpsViewBridgeClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MpsViewBridgePrivate));
 
@@ -143,6 +400,85 @@ mps_view_bridge_class_init (MpsViewBridgeClass *klass)
   object_class->set_property = mps_view_bridge_set_property;
   object_class->dispose = mps_view_bridge_dispose;
   object_class->finalize = mps_view_bridge_finalize;
+
+  pspec = g_param_spec_uint ("max-items",
+                             "Maximum items",
+                             "Maximum number of items to keep, 0 for no limit",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MAX_ITEMS, pspec);
+
+  pspec = g_param_spec_uint ("max-age",
+                             "Maximum age",
+                             "Maximum age in seconds of items to keep, "
+                             "0 for no limit",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MAX_AGE, pspec);
+
+  pspec = g_param_spec_uint ("queue-depth",
+                             "Queue depth",
+                             "Number of items waiting to be inserted",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READABLE);
+  g_object_class_install_property (object_class, PROP_QUEUE_DEPTH, pspec);
+
+  pspec = g_param_spec_double ("last-chunk-time",
+                               "Last chunk time",
+                               "Time in milliseconds spent on the last "
+                               "chunk of insertions",
+                               0.0, G_MAXDOUBLE, 0.0,
+                               G_PARAM_READABLE);
+  g_object_class_install_property (object_class, PROP_LAST_CHUNK_TIME, pspec);
+
+  pspec = g_param_spec_uint ("burst-window",
+                             "Burst window",
+                             "Seconds between posts from one author for them "
+                             "to count towards a burst",
+                             0, G_MAXUINT, DEFAULT_BURST_WINDOW,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_BURST_WINDOW, pspec);
+
+  pspec = g_param_spec_uint ("burst-threshold",
+                             "Burst threshold",
+                             "Number of posts in a burst before they share a "
+                             "card, 0 to never fold them",
+                             0, G_MAXUINT, DEFAULT_BURST_THRESHOLD,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_BURST_THRESHOLD, pspec);
+
+  signals[ITEM_ADDED_SIGNAL] = g_signal_new ("item-added",
+                                             MPS_TYPE_VIEW_BRIDGE,
+                                             G_SIGNAL_RUN_FIRST,
+                                             0,
+                                             NULL,
+                                             NULL,
+                                             g_cclosure_marshal_VOID__BOXED,
+                                             G_TYPE_NONE,
+                                             1,
+                                             MPS_TYPE_ITEM);
+
+  signals[ITEM_CHANGED_SIGNAL] = g_signal_new ("item-changed",
+                                               MPS_TYPE_VIEW_BRIDGE,
+                                               G_SIGNAL_RUN_FIRST,
+                                               0,
+                                               NULL,
+                                               NULL,
+                                               g_cclosure_marshal_VOID__BOXED,
+                                               G_TYPE_NONE,
+                                               1,
+                                               MPS_TYPE_ITEM);
+
+  signals[ITEM_REMOVED_SIGNAL] = g_signal_new ("item-removed",
+                                               MPS_TYPE_VIEW_BRIDGE,
+                                               G_SIGNAL_RUN_FIRST,
+                                               0,
+                                               NULL,
+                                               NULL,
+                                               g_cclosure_marshal_VOID__STRING,
+                                               G_TYPE_NONE,
+                                               1,
+                                               G_TYPE_STRING);
 }
 
 static void
@@ -150,15 +486,38 @@ mps_view_bridge_init (MpsViewBridge *self)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (self);
 
-  priv->item_uid_to_actor = g_hash_table_new_full (g_str_hash,
-                                                   g_str_equal,
-                                                   g_free,
-                                                   (GDestroyNotify)clutter_actor_destroy);
-
-  priv->refresh_id = g_timeout_add_seconds (REFRESH_TIME,
-                                            (GSourceFunc) _view_refresh_items_cb,
-                                            self);
-
+  /* Nothing to age out while nobody is looking */
+  priv->refresh_timer = mps_governor_timer_new (REFRESH_TIME,
+                                                _view_refresh_items_cb,
+                                                self);
+
+  priv->chunk_timer = g_timer_new ();
+  priv->index = mps_item_index_new ();
+  priv->archive = mps_item_index_new ();
+
+  priv->groups = g_hash_table_new_full (g_str_hash,
+                                        g_str_equal,
+                                        NULL,
+                                        (GDestroyNotify)_item_group_free);
+  priv->key_to_group = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->folded_to_group = g_hash_table_new_full (g_str_hash,
+                                                 g_str_equal,
+                                                 g_free,
+                                                 NULL);
+  priv->filtered = g_hash_table_new_full (g_str_hash,
+                                          g_str_equal,
+                                          g_free,
+                                          (GDestroyNotify)mps_item_unref);
+  priv->threader = mps_threader_new (_thread_link_cb, self);
+
+  priv->burst_window = DEFAULT_BURST_WINDOW;
+  priv->burst_threshold = DEFAULT_BURST_THRESHOLD;
+  priv->author_posts = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify)_author_posts_free);
+
+  mps_filter_add_notify (_filter_changed_cb, self);
 }
 
 MpsViewBridge *
@@ -168,402 +527,2010 @@ mps_view_bridge_new (void)
 }
 
 static gint
-_sw_item_sort_compare_func (SwItem *a,
-                            SwItem *b)
+_item_sort_compare_func (MpsItem *a,
+                         MpsItem *b)
 {
-  if (a->date.tv_sec < b->date.tv_sec)
+  if (a->date < b->date)
   {
     return -1;
-  } else if (a->date.tv_sec == b->date.tv_sec) {
+  } else if (a->date == b->date) {
     return 0;
   } else {
     return 1;
   }
 }
 
-#if 0
 static void
-_view_items_added_cb (SwClientView *view,
-                      GList            *items,
-                      MpsViewBridge    *bridge)
+_save_snapshot (MpsViewBridge *bridge)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
-  GList *l = NULL;
-  gint i = 0;
-  ClutterTimeline *timeline;
-  ClutterTimeline *last_timeline = NULL;
-  gint item_count = 0;
-
+  GError *error = NULL;
+  GHashTableIter iter;
+  gpointer group;
+  GList *items;
+  gint i;
 
-  /* TODO: Add some kind of delaying here */
-  items = g_list_sort (items,
-                       (GCompareFunc)_sw_item_sort_compare_func);
+  items = g_list_concat (mps_item_index_get_items (priv->index),
+                         mps_item_index_get_items (priv->archive));
 
-  if (!priv->score)
+  /* Collapsed replies and bursts are folded back up when loaded */
+  g_hash_table_iter_init (&iter, priv->groups);
+  while (g_hash_table_iter_next (&iter, NULL, &group))
   {
-    priv->score = clutter_score_new ();
-  } else {
-    GSList *timelines;
-
-    timelines = clutter_score_list_timelines (priv->score);
-    last_timeline = (ClutterTimeline *)(g_slist_last (timelines))->data;
-    g_slist_free (timelines);
-  }
-
-  item_count = g_list_length (items);
+    if (((MpsItemGroup *)group)->expanded)
+      continue;
 
-  if (item_count > THRESHOLD)
-  {
-    for (i = 0, l = items;
-         i < item_count - THRESHOLD;
-         i++, l=l->next)
+    for (i = 0; i < N_HIDDEN; i++)
     {
-      ClutterActor *actor;
-      SwItem   *item = (SwItem *)l->data;
-      actor = g_object_new (MPS_TYPE_TWEET_CARD,
-                            "item", item,
-                            NULL);
-      clutter_container_add_actor (CLUTTER_CONTAINER (priv->container),
-                                   actor);
-      clutter_container_lower_child (priv->container, actor, NULL);
-      clutter_container_child_set (CLUTTER_CONTAINER (priv->container),
-                                   actor,
-                                   "x-fill", TRUE,
-                                   "y-fill", FALSE,
-                                   "expand", FALSE,
-                                   NULL);
-      clutter_actor_set_height (actor, 100);
+      items = g_list_concat (items,
+                             g_list_copy (((MpsItemGroup *)group)->hidden[i]));
     }
-  } else {
-    l = items;
   }
 
-  for (; l != NULL; l = l->next)
+  if (!mps_feed_snapshot_save (priv->snapshot_path, items, &error))
   {
-    ClutterActor *actor;
-    SwItem   *item = (SwItem *)l->data;
-    ClutterTimeline *opacity_timeline;
-    ClutterAnimation *animation;
-    ClutterBehaviour *behave;
-    ClutterAlpha *alpha;
+    g_warning (G_STRLOC ": Unable to save feed snapshot: %s",
+               error->message);
+    g_clear_error (&error);
+  }
 
-    actor = g_object_new (MPS_TYPE_TWEET_CARD,
-                          "item", item,
-                          NULL);
-    clutter_container_add_actor (CLUTTER_CONTAINER (priv->container),
-                                 actor);
-    clutter_container_lower_child (priv->container, actor, NULL);
-    clutter_container_child_set (CLUTTER_CONTAINER (priv->container),
-                                 actor,
-                                 "x-fill", TRUE,
-                                 "y-fill", FALSE,
-                                 "expand", FALSE,
-                                 NULL);
-    clutter_actor_set_height (actor, 0);
-    clutter_actor_set_opacity (actor, 0);
+  g_list_free (items);
+}
 
-    animation = clutter_actor_animate (actor,
-                                       CLUTTER_LINEAR,
-                                       600,
-                                       "height", 100.0,
-                                       NULL);
-    timeline = clutter_animation_get_timeline (animation);
+static gboolean
+_save_snapshot_timeout_cb (gpointer userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
 
-    clutter_timeline_set_delay (timeline, 600);
-    clutter_timeline_stop (timeline);
-    clutter_timeline_add_marker_at_time (timeline, "opacity-trigger", 500);
+  priv->save_id = 0;
+  _save_snapshot (bridge);
 
-    clutter_score_append (priv->score,
-                          last_timeline,
-                          timeline);
+  return FALSE;
+}
 
-    opacity_timeline = clutter_timeline_new (100);
-    clutter_timeline_stop (opacity_timeline);
+/* Changes tend to come in bursts so write them out together */
+static void
+_queue_save_snapshot (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
 
-    alpha = clutter_alpha_new_full (opacity_timeline,
-                                    CLUTTER_LINEAR);
-    behave = clutter_behaviour_opacity_new (alpha,
-                                            0,
-                                            255);
-    clutter_behaviour_apply (behave, actor);
-    clutter_score_append_at_marker (priv->score,
-                                    timeline,
-                                    "opacity-trigger",
-                                    opacity_timeline);
-    last_timeline = timeline;
-  }
+  if (!priv->snapshot_path || priv->save_id != 0)
+    return;
 
-  clutter_score_start (priv->score);
+  priv->save_id = g_timeout_add_seconds (SNAPSHOT_SAVE_DELAY,
+                                         _save_snapshot_timeout_cb,
+                                         bridge);
 }
-#endif
-
 
+/* The count of copies and the thread toggle are kept on the card */
+static void
+_apply_group_state (MpsViewBridge *bridge,
+                    MpsItemGroup  *group)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
 
-static void _do_next_card_animation (MpsViewBridge *bridge);
+  mps_feed_box_set_item_occurrences (priv->container,
+                                     group->uuid,
+                                     1 + g_list_length (group->duplicates));
+  mps_feed_box_set_item_thread (priv->container,
+                                group->uuid,
+                                g_list_length (group->hidden[HIDDEN_REPLIES]),
+                                g_list_length (group->hidden[HIDDEN_BURST]),
+                                group->expanded);
+}
 
+/* The container only gets told about changes while it is on screen, when
+ * hidden they are recorded in the journal against the uuid instead.
+ */
 static void
-_animation_completed_cb (ClutterAnimation *animation,
-                         MpsViewBridge    *bridge)
+_container_insert (MpsViewBridge *bridge,
+                   MpsItem       *item,
+                   gint           position,
+                   gboolean       animate)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+
+  if (priv->journal)
+  {
+    g_hash_table_insert (priv->journal,
+                         g_strdup (item->uuid),
+                         mps_item_ref (item));
+    return;
+  }
+
+  mps_feed_box_insert_item (priv->container, item, position, animate);
 
-  priv->current_timeline = NULL;
+  group = g_hash_table_lookup (priv->groups, item->uuid);
 
-  _do_next_card_animation (bridge);
+  if (group)
+    _apply_group_state (bridge, group);
 }
 
 static void
-_do_next_card_animation (MpsViewBridge *bridge)
+_container_update (MpsViewBridge *bridge,
+                   MpsItem       *item,
+                   gint           old_position,
+                   gint           position)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
-  ClutterActor *actor;
-  ClutterAnimation *animation;
-  ClutterTimeline *timeline;
-  ClutterTimeline *opacity_timeline;
-  ClutterAlpha *alpha;
-  ClutterBehaviour *behave;
 
-  if (!priv->actors_to_animate)
+  if (position == old_position && !priv->journal)
   {
-    return;
+    mps_feed_box_update_item (priv->container, item);
+  } else {
+    /* The date moved so the row has to as well */
+    if (!priv->journal)
+      mps_feed_box_remove_item (priv->container, item->uuid);
+
+    _container_insert (bridge, item, position, FALSE);
   }
+}
 
-  /* Get current actor and update head of list */
-  actor = (ClutterActor *)priv->actors_to_animate->data;
-  priv->actors_to_animate = g_list_remove (priv->actors_to_animate,
-                                           actor);
-
-  animation = clutter_actor_animate (actor,
-                                     CLUTTER_LINEAR,
-                                     400,
-                                     "height", CARD_HEIGHT,
-                                     NULL);
-  timeline = clutter_animation_get_timeline (animation);
-  clutter_timeline_stop (timeline);
-  clutter_timeline_set_delay (timeline, 600);
-  clutter_timeline_start (timeline);
-  priv->current_timeline = timeline;
-
-  opacity_timeline = clutter_timeline_new (150);
-  clutter_timeline_set_delay (opacity_timeline, 850);
-  alpha = clutter_alpha_new_full (opacity_timeline, CLUTTER_EASE_OUT_QUAD);
-  g_object_unref (opacity_timeline);
-  behave = clutter_behaviour_opacity_new (alpha,
-                                          0,
-                                          255);
-  clutter_behaviour_apply (behave, actor);
-  g_signal_connect_swapped (opacity_timeline,
-                            "completed",
-                            (GCallback)g_object_unref,
-                            behave);
-  clutter_timeline_start (opacity_timeline);
-
-  g_signal_connect_after (animation,
-                          "completed",
-                          (GCallback)_animation_completed_cb,
-                          bridge);
-}
-
-gboolean
-_view_refresh_items_cb (MpsViewBridge *bridge)
+static void
+_container_remove (MpsViewBridge *bridge,
+                   const gchar   *uuid)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
-  GHashTableIter iter;
-  gpointer key;
-  MpsTweetCard *card;
 
-  g_hash_table_iter_init (&iter, priv->item_uid_to_actor);
+  if (priv->journal)
+  {
+    /* Added and removed while hidden, nothing to replay */
+    if (mps_feed_box_has_item (priv->container, uuid))
+      g_hash_table_insert (priv->journal, g_strdup (uuid), NULL);
+    else
+      g_hash_table_remove (priv->journal, uuid);
 
-  while (g_hash_table_iter_next (&iter, &key, (gpointer *) &card)) {
-    mps_tweet_card_refresh (card);
+    return;
   }
 
-  return TRUE;
+  mps_feed_box_remove_item (priv->container, uuid);
 }
 
 static void
-_view_items_added_cb (SwClientItemView *view,
-                      GList            *items,
-                      MpsViewBridge    *bridge)
+_container_set_group_state (MpsViewBridge *bridge,
+                            MpsItemGroup  *group)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
-  gint item_count = 0;
-  GList *l;
-  gint i = 0;
-  static ClutterActor *bottom_actor = NULL;
-
-  g_debug (G_STRLOC ": %s called", G_STRFUNC);
-
-  /* Oldest first */
-  items = g_list_sort (items,
-                       (GCompareFunc)_sw_item_sort_compare_func);
+  MpsItem *item;
 
-  item_count = g_list_length (items);
+  item = mps_item_index_lookup (priv->index, group->uuid);
 
+  if (!item)
+    return;
 
-  for (l = items; l; l = l->next)
+  /* Replaying re-inserts the row which picks up the state */
+  if (priv->journal)
   {
-    SwItem *item = (SwItem *)l->data;
-    ClutterActor *actor;
+    g_hash_table_insert (priv->journal,
+                         g_strdup (item->uuid),
+                         mps_item_ref (item));
+    return;
+  }
 
-    if (priv->func)
-    {
-      actor = priv->func (bridge, item, priv->userdata);
-    } else {
-      actor = g_object_new (MPS_TYPE_TWEET_CARD,
-                            "item", item,
-                            NULL);
-    }
+  _apply_group_state (bridge, group);
+}
 
-    clutter_container_add_actor (CLUTTER_CONTAINER (priv->container),
-                                 actor);
+static void
+_show_item (MpsViewBridge *bridge,
+            MpsItem       *item,
+            gboolean       animate)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  gint position;
 
-    g_hash_table_insert (priv->item_uid_to_actor,
-                         g_strdup (item->uuid),
-                         actor);
+  /* Late or backfilled items land where their date says they should */
+  position = mps_item_index_insert (priv->index, item);
+  _container_insert (bridge, item, position, animate);
+  _queue_save_snapshot (bridge);
 
-    /* Position it at the top */
-    clutter_container_lower_child (priv->container, actor, NULL);
+  g_signal_emit (bridge, signals[ITEM_ADDED_SIGNAL], 0, item);
+}
 
-    clutter_container_child_set (CLUTTER_CONTAINER (priv->container),
-                                 actor,
-                                 "x-fill", TRUE,
-                                 "y-fill", FALSE,
-                                 "expand", FALSE,
-                                 NULL);
+static void
+_group_add_keys (MpsViewBridge *bridge,
+                 MpsItemGroup  *group)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  gint i;
 
-    if (i < item_count - THRESHOLD)
+  for (i = 0; i < G_N_ELEMENTS (group->keys); i++)
+  {
+    if (group->keys[i] &&
+        !g_hash_table_lookup (priv->key_to_group, group->keys[i]))
     {
-      clutter_actor_set_height (actor, CARD_HEIGHT);
-    } else {
-      clutter_actor_set_height (actor, 0);
-      priv->actors_to_animate = g_list_append (priv->actors_to_animate,
-                                               actor);
-      clutter_actor_set_opacity (actor, 0);
+      g_hash_table_insert (priv->key_to_group, group->keys[i], group);
     }
+  }
+}
+
+static void
+_group_remove_keys (MpsViewBridge *bridge,
+                    MpsItemGroup  *group)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  gint i;
 
-    if (!bottom_actor)
+  for (i = 0; i < G_N_ELEMENTS (group->keys); i++)
+  {
+    if (group->keys[i] &&
+        g_hash_table_lookup (priv->key_to_group, group->keys[i]) == group)
     {
-      bottom_actor = actor;
-      mx_stylable_set_style_class (MX_STYLABLE (actor), "mps-tweet-card-last");
+      g_hash_table_remove (priv->key_to_group, group->keys[i]);
     }
-
-    i++;
   }
+}
 
-  /* Deal with the overflow on the pending items */
-  while (g_list_length (priv->actors_to_animate) > THRESHOLD)
-  {
-    ClutterActor *actor = (ClutterActor *)priv->actors_to_animate->data;
-
-    clutter_actor_set_height (actor, CARD_HEIGHT);
-    clutter_actor_set_opacity (actor, 255);
+static gboolean
+_group_has_hidden (MpsItemGroup *group)
+{
+  gint i;
 
-    priv->actors_to_animate = g_list_remove (priv->actors_to_animate, actor);
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    if (group->hidden[i])
+      return TRUE;
   }
 
-  /* We have a started chain of animations */
-  if (!priv->current_timeline)
-    _do_next_card_animation (bridge);
+  return FALSE;
 }
 
-static void
-_view_items_removed_cb (SwClientItemView *view,
-                        GList            *items,
-                        MpsViewBridge    *bridge)
+/* Where in the group the uuid is folded, hidden is set to the kind of
+ * hidden item or -1 for a duplicate.
+ */
+static GList *
+_find_folded (MpsItemGroup *group,
+              const gchar  *uuid,
+              gint         *hidden)
 {
-  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *l;
+  gint i;
+
+  for (l = group->duplicates; l; l = l->next)
+  {
+    if (g_str_equal (((MpsItem *)l->data)->uuid, uuid))
+    {
+      *hidden = -1;
+      return l;
+    }
+  }
+
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    for (l = group->hidden[i]; l; l = l->next)
+    {
+      if (g_str_equal (((MpsItem *)l->data)->uuid, uuid))
+      {
+        *hidden = i;
+        return l;
+      }
+    }
+  }
 
+  return NULL;
 }
 
-static void
-_view_items_changed_cb (SwClientItemView *view,
-                        GList            *items,
-                        MpsViewBridge    *bridge)
+/* Replace the folded copy, reply or burst post with the same uuid, returns
+ * FALSE if there isn't one.
+ */
+static gboolean
+_replace_folded (MpsViewBridge *bridge,
+                 MpsItem       *item)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+  MpsItem *folded;
+  gint hidden;
   GList *l;
 
-  for (l = items; l; l = l->next)
-  {
-    SwItem *item = (SwItem *)l->data;
-    ClutterActor *actor;
+  group = g_hash_table_lookup (priv->folded_to_group, item->uuid);
 
-    actor = g_hash_table_lookup (priv->item_uid_to_actor,
-                                 item->uuid);
+  if (!group)
+    return FALSE;
 
-    if (actor)
-    {
-      g_object_set (actor,
-                    "item", item,
-                    NULL);
-    }
+  l = _find_folded (group, item->uuid, &hidden);
+
+  if (!l)
+    return TRUE;
+
+  folded = (MpsItem *)l->data;
+  l->data = mps_item_ref (item);
+  mps_item_unref (folded);
+
+  /* Expanded items have rows of their own to keep up to date */
+  if (hidden >= 0 && group->expanded)
+  {
+    gint old_position, position;
+
+    old_position = mps_item_index_get_position (priv->index, item->uuid);
+    position = mps_item_index_update (priv->index, item);
+    _container_update (bridge, item, old_position, position);
   }
-}
 
+  return TRUE;
+}
 
-void
-mps_view_bridge_set_view (MpsViewBridge    *bridge,
-                          SwClientItemView *view)
+static gchar *
+_get_author_key (MpsItem *item)
 {
-  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  gchar *name, *key;
 
-  /* Can only be called once */
-  g_assert (!priv->view);
-  priv->view = g_object_ref (view);
+  if (!item->authorid)
+    return NULL;
 
-  g_signal_connect (priv->view,
-                    "items-added",
-                    (GCallback)_view_items_added_cb,
-                    bridge);
-  g_signal_connect (priv->view,
-                    "items-removed",
-                    (GCallback)_view_items_removed_cb,
-                    bridge);
-  g_signal_connect (priv->view,
-                    "items-changed",
-                    (GCallback)_view_items_changed_cb,
-                    bridge);
+  name = g_ascii_strdown (item->authorid, -1);
+  key = g_strconcat (item->service, "/", name, NULL);
+  g_free (name);
 
-  sw_client_item_view_start (priv->view);
+  return key;
 }
 
-void
-mps_view_bridge_set_factory_func (MpsViewBridge            *bridge,
-                                  MpsViewBridgeFactoryFunc  func,
-                                  gpointer                  userdata)
+/* Whether the item is still on a card, on its own or folded */
+static gboolean
+_is_around (MpsViewBridge *bridge,
+            const gchar   *uuid)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
 
-  priv->func = func;
-  priv->userdata = userdata;
+  return (mps_item_index_lookup (priv->index, uuid) ||
+          g_hash_table_lookup (priv->folded_to_group, uuid));
 }
 
-void
-mps_view_bridge_set_container (MpsViewBridge    *bridge,
-                               ClutterContainer *container)
+static gint
+_compare_posts_newest_first (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      userdata)
 {
-  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  const MpsAuthorPost *post_a = a, *post_b = b;
 
-  /* Can only be called once */
-  g_assert (!priv->container);
-  priv->container = g_object_ref (container);
+  return (post_b->date > post_a->date) - (post_b->date < post_a->date);
 }
 
-SwClientItemView *
-mps_view_bridge_get_view (MpsViewBridge *bridge)
+/* The uuids of the author's other posts within the burst window of the
+ * item, newest first, once there are enough of them to count as a burst.
+ * The item is remembered for next time and posts that have gone are
+ * dropped on the way.
+ */
+static GList *
+_get_burst (MpsViewBridge *bridge,
+            MpsItem       *item)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsAuthorPost *post;
+  GList *l, *next, *burst = NULL;
+  gboolean known = FALSE;
+  GQueue *posts;
+  gchar *key;
 
-  return priv->view;
+  if (priv->burst_threshold < 2)
+    return NULL;
+
+  key = _get_author_key (item);
+
+  if (!key)
+    return NULL;
+
+  posts = g_hash_table_lookup (priv->author_posts, key);
+
+  if (!posts)
+  {
+    posts = g_queue_new ();
+    g_hash_table_insert (priv->author_posts, key, posts);
+  } else {
+    g_free (key);
+  }
+
+  for (l = posts->head; l; l = next)
+  {
+    post = (MpsAuthorPost *)l->data;
+    next = l->next;
+
+    if (g_str_equal (post->uuid, item->uuid))
+    {
+      known = TRUE;
+    } else if (!_is_around (bridge, post->uuid)) {
+      _author_post_free (post);
+      g_queue_delete_link (posts, l);
+    } else if (ABS (post->date - item->date) <= priv->burst_window) {
+      burst = g_list_prepend (burst, post->uuid);
+    }
+  }
+
+  if (!known)
+  {
+    post = g_slice_new0 (MpsAuthorPost);
+    post->uuid = g_strdup (item->uuid);
+    post->date = item->date;
+    g_queue_insert_sorted (posts, post, _compare_posts_newest_first, NULL);
+  }
+
+  if (g_list_length (burst) + 1 < priv->burst_threshold)
+  {
+    g_list_free (burst);
+    return NULL;
+  }
+
+  return g_list_reverse (burst);
 }
 
-ClutterContainer *
-mps_view_bridge_get_container (MpsViewBridge *bridge)
+/* Drop the posts that have gone from every author, and authors with none */
+static void
+_prune_author_posts (MpsViewBridge *bridge)
 {
   MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GHashTableIter iter;
+  gpointer posts;
+  GList *l, *next;
 
-  return priv->container;
+  g_hash_table_iter_init (&iter, priv->author_posts);
+  while (g_hash_table_iter_next (&iter, NULL, &posts))
+  {
+    for (l = ((GQueue *)posts)->head; l; l = next)
+    {
+      next = l->next;
+
+      if (!_is_around (bridge, ((MpsAuthorPost *)l->data)->uuid))
+      {
+        _author_post_free ((MpsAuthorPost *)l->data);
+        g_queue_delete_link ((GQueue *)posts, l);
+      }
+    }
+
+    if (g_queue_is_empty ((GQueue *)posts))
+      g_hash_table_iter_remove (&iter);
+  }
 }
 
+/* Fold the item into the card for an earlier copy of the same post if there
+ * is one, or the card for a burst it is part of, otherwise show it.
+ */
+static void
+_insert_item (MpsViewBridge *bridge,
+              MpsItem       *item,
+              gboolean       animate)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group = NULL;
+  gchar *keys[2];
+  GList *burst;
+  gint i;
+
+  if (_replace_folded (bridge, item))
+    return;
+
+  /* Muted items never get as far as a card */
+  if (mps_filter_matches (item))
+  {
+    g_hash_table_insert (priv->filtered,
+                         g_strdup (item->uuid),
+                         mps_item_ref (item));
+    return;
+  }
 
+  keys[0] = mps_fingerprint_url (item->url);
+  keys[1] = mps_fingerprint_content (item->content);
+
+  for (i = 0; i < G_N_ELEMENTS (keys) && !group; i++)
+  {
+    if (keys[i])
+      group = g_hash_table_lookup (priv->key_to_group, keys[i]);
+  }
+
+  if (group)
+  {
+    g_free (keys[0]);
+    g_free (keys[1]);
+
+    group->duplicates = g_list_append (group->duplicates,
+                                       mps_item_ref (item));
+    g_hash_table_insert (priv->folded_to_group,
+                         g_strdup (item->uuid),
+                         group);
+    _container_set_group_state (bridge, group);
+
+    /* Replies to any copy belong with the card */
+    mps_threader_add (priv->threader, item);
+    return;
+  }
+
+  burst = _get_burst (bridge, item);
+
+  /* Only the author's latest post in a burst gets a card */
+  if (burst && _fold_into_burst (bridge, item, burst))
+  {
+    g_free (keys[0]);
+    g_free (keys[1]);
+    g_list_free (burst);
+
+    mps_threader_add (priv->threader, item);
+    return;
+  }
+
+  /* Nothing to match later copies against */
+  if (keys[0] || keys[1])
+  {
+    group = g_slice_new0 (MpsItemGroup);
+    group->uuid = g_strdup (item->uuid);
+    group->keys[0] = keys[0];
+    group->keys[1] = keys[1];
+
+    g_hash_table_insert (priv->groups, group->uuid, group);
+    _group_add_keys (bridge, group);
+  }
+
+  _show_item (bridge, item, animate);
+
+  if (burst)
+  {
+    _collect_burst (bridge, item->uuid, burst);
+    g_list_free (burst);
+  }
+
+  /* May fold the item straight into a conversation */
+  mps_threader_add (priv->threader, item);
+}
+
+static void
+_archive_item (MpsViewBridge *bridge,
+               MpsItem       *item)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  mps_item_index_insert (priv->archive, item);
+
+  if (mps_item_index_get_n_items (priv->archive) > ARCHIVE_MAX_ITEMS)
+  {
+    mps_item_index_remove (priv->archive,
+                           mps_item_index_get_oldest (priv->archive)->uuid);
+  }
+
+  _queue_save_snapshot (bridge);
+}
+
+/* Forget the copies and hidden items folded into the item as it ages out.
+ * The hidden ones are older than the item on show so go to the archive
+ * with it.
+ */
+static void
+_forget_folded (MpsViewBridge *bridge,
+                const gchar   *uuid)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+  GList *l;
+  gint i;
+
+  group = g_hash_table_lookup (priv->groups, uuid);
+
+  if (!group)
+    return;
+
+  for (l = group->duplicates; l; l = l->next)
+  {
+    g_hash_table_remove (priv->folded_to_group,
+                         ((MpsItem *)l->data)->uuid);
+    mps_item_unref ((MpsItem *)l->data);
+  }
+
+  g_list_free (group->duplicates);
+  group->duplicates = NULL;
+
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    for (l = group->hidden[i]; l; l = l->next)
+    {
+      MpsItem *hidden = (MpsItem *)l->data;
+
+      if (group->expanded &&
+          mps_item_index_remove (priv->index, hidden->uuid) >= 0)
+      {
+        _container_remove (bridge, hidden->uuid);
+      }
+
+      g_hash_table_remove (priv->folded_to_group, hidden->uuid);
+      _archive_item (bridge, hidden);
+      mps_item_unref (hidden);
+    }
+
+    g_list_free (group->hidden[i]);
+    group->hidden[i] = NULL;
+  }
+
+  group->expanded = FALSE;
+}
+
+static void
+_remove_item (MpsViewBridge *bridge,
+              const gchar   *uuid)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+  gchar *removed_uuid;
+  gint hidden;
+  GList *l;
+
+  /* The uuid may belong to the item we are about to drop */
+  removed_uuid = g_strdup (uuid);
+
+  group = g_hash_table_lookup (priv->folded_to_group, removed_uuid);
+
+  /* Just one folded item fewer */
+  if (group)
+  {
+    l = _find_folded (group, removed_uuid, &hidden);
+
+    if (l && hidden >= 0)
+    {
+      if (group->expanded &&
+          mps_item_index_remove (priv->index, removed_uuid) >= 0)
+      {
+        _container_remove (bridge, removed_uuid);
+        _queue_save_snapshot (bridge);
+      }
+
+      mps_item_unref ((MpsItem *)l->data);
+      group->hidden[hidden] = g_list_delete_link (group->hidden[hidden], l);
+
+      if (!_group_has_hidden (group))
+        group->expanded = FALSE;
+    } else if (l) {
+      mps_item_unref ((MpsItem *)l->data);
+      group->duplicates = g_list_delete_link (group->duplicates, l);
+    }
+
+    g_hash_table_remove (priv->folded_to_group, removed_uuid);
+    _container_set_group_state (bridge, group);
+
+    g_free (removed_uuid);
+    return;
+  }
+
+  if (mps_item_index_remove (priv->index, removed_uuid) >= 0)
+  {
+    _container_remove (bridge, removed_uuid);
+    _queue_save_snapshot (bridge);
+
+    g_signal_emit (bridge, signals[ITEM_REMOVED_SIGNAL], 0, removed_uuid);
+  }
+
+  group = g_hash_table_lookup (priv->groups, removed_uuid);
+
+  if (group)
+  {
+    g_hash_table_steal (priv->groups, group->uuid);
+
+    if (group->duplicates || _group_has_hidden (group))
+    {
+      MpsItem *promoted;
+
+      /* The next copy, or failing that the latest hidden item, takes over
+       * the card
+       */
+      if (group->duplicates)
+      {
+        promoted = (MpsItem *)group->duplicates->data;
+        group->duplicates = g_list_delete_link (group->duplicates,
+                                                group->duplicates);
+      } else {
+        gint newest = -1;
+        gint i;
+
+        for (i = 0; i < N_HIDDEN; i++)
+        {
+          if (group->hidden[i] &&
+              (newest < 0 ||
+               ((MpsItem *)group->hidden[i]->data)->date >
+               ((MpsItem *)group->hidden[newest]->data)->date))
+          {
+            newest = i;
+          }
+        }
+
+        promoted = (MpsItem *)group->hidden[newest]->data;
+        group->hidden[newest] = g_list_delete_link (group->hidden[newest],
+                                                    group->hidden[newest]);
+
+        if (group->expanded &&
+            mps_item_index_remove (priv->index, promoted->uuid) >= 0)
+        {
+          _container_remove (bridge, promoted->uuid);
+        }
+
+        if (!_group_has_hidden (group))
+          group->expanded = FALSE;
+      }
+
+      g_hash_table_remove (priv->folded_to_group, promoted->uuid);
+
+      g_free (group->uuid);
+      group->uuid = g_strdup (promoted->uuid);
+      g_hash_table_insert (priv->groups, group->uuid, group);
+
+      _show_item (bridge, promoted, FALSE);
+      mps_item_unref (promoted);
+    } else {
+      _group_remove_keys (bridge, group);
+      _item_group_free (group);
+    }
+  }
+
+  g_free (removed_uuid);
+}
+
+static void
+_update_item (MpsViewBridge *bridge,
+              MpsItem       *item)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  gint old_position, position;
+
+  /* Nothing to redo for the card */
+  if (mps_item_equal (mps_item_index_lookup (priv->index, item->uuid), item))
+    return;
+
+  old_position = mps_item_index_get_position (priv->index, item->uuid);
+  position = mps_item_index_update (priv->index, item);
+
+  _container_update (bridge, item, old_position, position);
+  _queue_save_snapshot (bridge);
+
+  g_signal_emit (bridge, signals[ITEM_CHANGED_SIGNAL], 0, item);
+}
+
+static gint
+_compare_newest_first (gconstpointer a,
+                       gconstpointer b)
+{
+  const MpsItem *item_a = a, *item_b = b;
+
+  return (item_b->date > item_a->date) - (item_b->date < item_a->date);
+}
+
+/* Hidden items have rows of their own while the card is expanded, placed
+ * by their own date as the rows are all the same height.
+ */
+static void
+_show_hidden (MpsViewBridge *bridge,
+              GList         *items)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *l;
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item = (MpsItem *)l->data;
+    gint position;
+
+    position = mps_item_index_insert (priv->index, item);
+    _container_insert (bridge, item, position, FALSE);
+  }
+}
+
+static void
+_hide_hidden (MpsViewBridge *bridge,
+              GList         *items)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *l;
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item = (MpsItem *)l->data;
+
+    if (mps_item_index_remove (priv->index, item->uuid) >= 0)
+      _container_remove (bridge, item->uuid);
+  }
+}
+
+/* The group the item is shown or folded in, an item shown on its own gets
+ * a group of its own. NULL if the item isn't around any more.
+ */
+static MpsItemGroup *
+_ensure_group (MpsViewBridge *bridge,
+               const gchar   *uuid)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+
+  group = g_hash_table_lookup (priv->folded_to_group, uuid);
+
+  if (!group)
+    group = g_hash_table_lookup (priv->groups, uuid);
+
+  if (group)
+    return group;
+
+  if (!mps_item_index_lookup (priv->index, uuid))
+    return NULL;
+
+  group = g_slice_new0 (MpsItemGroup);
+  group->uuid = g_strdup (uuid);
+  g_hash_table_insert (priv->groups, group->uuid, group);
+
+  return group;
+}
+
+/* Fold one card's group into another's, the card itself becomes a hidden
+ * item of the given kind.
+ */
+static void
+_join_groups (MpsViewBridge *bridge,
+              MpsItemGroup  *into,
+              MpsItemGroup  *group,
+              MpsHiddenKind  kind)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItem *head;
+  GList *moved[N_HIDDEN], *l;
+  gint i;
+
+  head = mps_item_index_lookup (priv->index, group->uuid);
+
+  if (!head)
+    return;
+
+  mps_item_ref (head);
+
+  for (i = 0; i < N_HIDDEN && group->expanded; i++)
+    _hide_hidden (bridge, group->hidden[i]);
+
+  /* Out of the tables first so removing the card doesn't promote */
+  g_hash_table_steal (priv->groups, group->uuid);
+  _group_remove_keys (bridge, group);
+  _remove_item (bridge, head->uuid);
+
+  group->hidden[kind] = g_list_prepend (group->hidden[kind], head);
+
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    moved[i] = group->hidden[i];
+    group->hidden[i] = NULL;
+
+    for (l = moved[i]; l; l = l->next)
+    {
+      g_hash_table_insert (priv->folded_to_group,
+                           g_strdup (((MpsItem *)l->data)->uuid),
+                           into);
+    }
+  }
+
+  for (l = group->duplicates; l; l = l->next)
+  {
+    g_hash_table_insert (priv->folded_to_group,
+                         g_strdup (((MpsItem *)l->data)->uuid),
+                         into);
+  }
+
+  into->duplicates = g_list_concat (into->duplicates, group->duplicates);
+  group->duplicates = NULL;
+
+  /* Later copies of the old card's post still find the conversation */
+  for (i = 0; i < G_N_ELEMENTS (group->keys); i++)
+  {
+    if (!into->keys[i])
+    {
+      into->keys[i] = group->keys[i];
+      group->keys[i] = NULL;
+    }
+  }
+
+  _group_add_keys (bridge, into);
+  _item_group_free (group);
+
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    if (into->expanded)
+      _show_hidden (bridge, moved[i]);
+
+    into->hidden[i] = g_list_sort (g_list_concat (into->hidden[i], moved[i]),
+                                   _compare_newest_first);
+  }
+
+  _container_set_group_state (bridge, into);
+  _queue_save_snapshot (bridge);
+}
+
+static void
+_thread_link_cb (const gchar *reply_uuid,
+                 const gchar *parent_uuid,
+                 gpointer     userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *reply_group, *parent_group;
+  MpsItem *reply_head, *parent_head;
+
+  reply_group = _ensure_group (bridge, reply_uuid);
+  parent_group = _ensure_group (bridge, parent_uuid);
+
+  if (!reply_group || !parent_group || reply_group == parent_group)
+    return;
+
+  reply_head = mps_item_index_lookup (priv->index, reply_group->uuid);
+  parent_head = mps_item_index_lookup (priv->index, parent_group->uuid);
+
+  if (!reply_head || !parent_head)
+    return;
+
+  /* The conversation is shown at its latest post */
+  if (reply_head->date >= parent_head->date)
+    _join_groups (bridge, reply_group, parent_group, HIDDEN_REPLIES);
+  else
+    _join_groups (bridge, parent_group, reply_group, HIDDEN_REPLIES);
+}
+
+/* Bring the rest of the burst under the card for uuid */
+static void
+_collect_burst (MpsViewBridge *bridge,
+                const gchar   *uuid,
+                GList         *burst)
+{
+  MpsItemGroup *into, *group;
+  GList *l;
+
+  into = _ensure_group (bridge, uuid);
+
+  if (!into)
+    return;
+
+  for (l = burst; l; l = l->next)
+  {
+    group = _ensure_group (bridge, (const gchar *)l->data);
+
+    if (group && group != into)
+      _join_groups (bridge, into, group, HIDDEN_BURST);
+  }
+}
+
+/* Fold the item under the card for the author's latest post in the burst,
+ * returns FALSE if the item is the latest and should have the card itself.
+ */
+static gboolean
+_fold_into_burst (MpsViewBridge *bridge,
+                  MpsItem       *item,
+                  GList         *burst)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+  MpsItem *head;
+
+  group = _ensure_group (bridge, (const gchar *)burst->data);
+
+  if (!group)
+    return FALSE;
+
+  head = mps_item_index_lookup (priv->index, group->uuid);
+
+  if (!head || head->date < item->date)
+    return FALSE;
+
+  group->hidden[HIDDEN_BURST] =
+    g_list_insert_sorted (group->hidden[HIDDEN_BURST],
+                          mps_item_ref (item),
+                          _compare_newest_first);
+  g_hash_table_insert (priv->folded_to_group,
+                       g_strdup (item->uuid),
+                       group);
+
+  if (group->expanded)
+  {
+    gint position;
+
+    position = mps_item_index_insert (priv->index, item);
+    _container_insert (bridge, item, position, FALSE);
+  }
+
+  _collect_burst (bridge, group->uuid, burst);
+  _container_set_group_state (bridge, group);
+  _queue_save_snapshot (bridge);
+
+  return TRUE;
+}
+
+/* Move the oldest items to the archive until we are back inside the
+ * retention window.
+ */
+static void
+_apply_retention (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GTimeVal now;
+  guint n_items;
+
+  if (!priv->container || priv->paged)
+    return;
+
+  g_get_current_time (&now);
+
+  while ((n_items = mps_item_index_get_n_items (priv->index)) > 0)
+  {
+    MpsItem *oldest;
+
+    oldest = mps_item_index_get_oldest (priv->index);
+
+    if ((priv->max_items > 0 && n_items > priv->max_items) ||
+        (priv->max_age > 0 && oldest->date < now.tv_sec - priv->max_age))
+    {
+      _archive_item (bridge, oldest);
+      _forget_folded (bridge, oldest->uuid);
+      _remove_item (bridge, oldest->uuid);
+    } else {
+      break;
+    }
+  }
+}
+
+static gboolean
+_is_outside_retention (MpsViewBridge *bridge,
+                       MpsItem       *item)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GTimeVal now;
+
+  if (priv->max_age > 0)
+  {
+    g_get_current_time (&now);
+
+    if (item->date < now.tv_sec - priv->max_age)
+      return TRUE;
+  }
+
+  /* Full up and older than everything we have so it would just be evicted */
+  if (priv->max_items > 0 &&
+      mps_item_index_get_n_items (priv->index) >= priv->max_items)
+  {
+    MpsItem *oldest = mps_item_index_get_oldest (priv->index);
+
+    if (item->date < oldest->date)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+_view_refresh_items_cb (gpointer userdata)
+{
+  /* Cards keep their own times up to date while they are on screen but
+   * items age out even when nothing new arrives.
+   */
+  _apply_retention (MPS_VIEW_BRIDGE (userdata));
+  _prune_author_posts (MPS_VIEW_BRIDGE (userdata));
+}
+
+/* Insert queued items, newest first, until the budget for this frame is
+ * spent. Returns TRUE if there are more left to do.
+ */
+static gboolean
+_ingest_chunk (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  g_timer_start (priv->chunk_timer);
+
+  while (priv->pending)
+  {
+    MpsPendingItem *pending = (MpsPendingItem *)priv->pending->data;
+
+    priv->pending = g_list_delete_link (priv->pending, priv->pending);
+    priv->n_pending--;
+
+    if (_is_outside_retention (bridge, pending->item))
+      _archive_item (bridge, pending->item);
+    else
+      _insert_item (bridge, pending->item, pending->animate);
+
+    _pending_item_free (pending);
+
+    if (g_timer_elapsed (priv->chunk_timer, NULL) * 1000.0 >= INGEST_BUDGET)
+      break;
+  }
+
+  _apply_retention (bridge);
+
+  priv->last_chunk_time = g_timer_elapsed (priv->chunk_timer, NULL) * 1000.0;
+
+  g_object_notify (G_OBJECT (bridge), "queue-depth");
+  g_object_notify (G_OBJECT (bridge), "last-chunk-time");
+
+  return (priv->pending != NULL);
+}
+
+static gboolean
+_ingest_idle_cb (gpointer userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (_ingest_chunk (bridge))
+    return TRUE;
+
+  priv->ingest_id = 0;
+  return FALSE;
+}
+
+static void
+_journal_value_free (gpointer data)
+{
+  if (data)
+    mps_item_unref ((MpsItem *)data);
+}
+
+static void
+_start_journal (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->journal)
+    return;
+
+  priv->journal = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         _journal_value_free);
+}
+
+static gint
+_journal_position_compare_func (gconstpointer a,
+                                gconstpointer b,
+                                gpointer      userdata)
+{
+  MpsItemIndex *index = (MpsItemIndex *)userdata;
+
+  return mps_item_index_get_position (index, ((MpsItem *)a)->uuid) -
+         mps_item_index_get_position (index, ((MpsItem *)b)->uuid);
+}
+
+/* The index is always current so bring the container back in line with it:
+ * take out every row the journal mentions, then put back the ones that are
+ * still wanted in order.
+ */
+static void
+_replay_journal (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GHashTableIter iter;
+  gpointer uuid, item;
+  GHashTable *journal;
+  GList *items = NULL, *l;
+
+  if (!priv->journal)
+    return;
+
+  journal = priv->journal;
+  priv->journal = NULL;
+
+  g_debug (G_STRLOC ": Replaying %d journalled changes",
+           g_hash_table_size (journal));
+
+  g_hash_table_iter_init (&iter, journal);
+  while (g_hash_table_iter_next (&iter, &uuid, &item))
+  {
+    mps_feed_box_remove_item (priv->container, (const gchar *)uuid);
+
+    if (item && mps_item_index_lookup (priv->index, (const gchar *)uuid) == item)
+      items = g_list_prepend (items, item);
+  }
+
+  items = g_list_sort_with_data (items,
+                                 _journal_position_compare_func,
+                                 priv->index);
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *journalled = (MpsItem *)l->data;
+
+    _container_insert (bridge,
+                       journalled,
+                       mps_item_index_get_position (priv->index,
+                                                    journalled->uuid),
+                       FALSE);
+  }
+
+  g_list_free (items);
+  g_hash_table_destroy (journal);
+}
+
+static void
+_container_mapped_notify_cb (GObject       *object,
+                             GParamSpec    *pspec,
+                             MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (CLUTTER_ACTOR_IS_MAPPED (object))
+  {
+    _replay_journal (bridge);
+  } else {
+    _start_journal (bridge);
+
+    /* Start from the top again next time */
+    if (priv->paged)
+    {
+      priv->paged = FALSE;
+      _apply_retention (bridge);
+    }
+  }
+}
+
+static gboolean
+_reconcile_cb (gpointer userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GHashTableIter iter;
+  gpointer uuid;
+
+  g_debug (G_STRLOC ": Dropping %d stale items",
+           g_hash_table_size (priv->unconfirmed_uuids));
+
+  g_hash_table_iter_init (&iter, priv->unconfirmed_uuids);
+  while (g_hash_table_iter_next (&iter, &uuid, NULL))
+    _remove_item (bridge, (const gchar *)uuid);
+
+  g_hash_table_destroy (priv->unconfirmed_uuids);
+  priv->unconfirmed_uuids = NULL;
+  priv->reconcile_id = 0;
+
+  return FALSE;
+}
+
+/* Both lists newest first, returns them merged likewise */
+static GList *
+_merge_pending (GList *a,
+                GList *b)
+{
+  GList *merged = NULL;
+
+  while (a && b)
+  {
+    MpsPendingItem *pa = (MpsPendingItem *)a->data;
+    MpsPendingItem *pb = (MpsPendingItem *)b->data;
+
+    if (pa->item->date >= pb->item->date)
+    {
+      merged = g_list_prepend (merged, pa);
+      a = g_list_delete_link (a, a);
+    } else {
+      merged = g_list_prepend (merged, pb);
+      b = g_list_delete_link (b, b);
+    }
+  }
+
+  return g_list_concat (g_list_reverse (merged), a ? a : b);
+}
+
+/* Takes over the list and the items in it, which should be newest first.
+ * Each batch is merged into the queue so items from several sources come
+ * out as one stream ordered by date. Unless ingest_now is set the queue is
+ * left entirely to the idle, e.g. for items forwarded from a source bridge
+ * while it is spending its own budget.
+ */
+static void
+_add_items (MpsViewBridge *bridge,
+            GList         *items,
+            gint           n_animate,
+            gboolean       ingest_now)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *batch = NULL, *l;
+
+  /* Give the rest of the initial results a moment to arrive before dropping
+   * whatever we were showing that the view doesn't know about.
+   */
+  if (priv->unconfirmed_uuids && priv->reconcile_id == 0)
+  {
+    priv->reconcile_id = g_timeout_add_seconds (RECONCILE_GRACE_TIME,
+                                                _reconcile_cb,
+                                                bridge);
+  }
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item = (MpsItem *)l->data;
+    MpsPendingItem *pending;
+
+    if (priv->unconfirmed_uuids)
+      g_hash_table_remove (priv->unconfirmed_uuids, item->uuid);
+
+    /* Delivered again, retention decides afresh where it goes */
+    mps_item_index_remove (priv->archive, item->uuid);
+
+    /* Already showing, keep the card and swap in the live copy */
+    if (mps_item_index_lookup (priv->index, item->uuid) ||
+        g_hash_table_lookup (priv->folded_to_group, item->uuid) ||
+        g_hash_table_lookup (priv->filtered, item->uuid))
+    {
+      _change_item (bridge, item);
+      mps_item_unref (item);
+      continue;
+    }
+
+    /* Takes over the reference, only the newest few get animated in */
+    pending = g_slice_new0 (MpsPendingItem);
+    pending->item = item;
+    pending->animate = (n_animate-- > 0);
+    batch = g_list_prepend (batch, pending);
+  }
+
+  g_list_free (items);
+
+  priv->n_pending += g_list_length (batch);
+  priv->pending = _merge_pending (priv->pending, g_list_reverse (batch));
+
+  /* The newest items go in straight away, the rest follow between frames */
+  if (ingest_now)
+  {
+    if (_ingest_chunk (bridge) && priv->ingest_id == 0)
+      priv->ingest_id = g_idle_add (_ingest_idle_cb, bridge);
+  } else if (priv->pending && priv->ingest_id == 0) {
+    priv->ingest_id = g_idle_add (_ingest_idle_cb, bridge);
+  }
+}
+
+/* Find a queued item that has not made it into the container yet */
+static GList *
+_find_pending (MpsViewBridge *bridge,
+               const gchar   *uuid)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *l;
+
+  for (l = priv->pending; l; l = l->next)
+  {
+    MpsPendingItem *pending = (MpsPendingItem *)l->data;
+
+    if (g_str_equal (pending->item->uuid, uuid))
+      return l;
+  }
+
+  return NULL;
+}
+
+static void
+_change_item (MpsViewBridge *bridge,
+              MpsItem       *item)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *link;
+
+  link = _find_pending (bridge, item->uuid);
+
+  if (link)
+  {
+    MpsPendingItem *pending = (MpsPendingItem *)link->data;
+
+    mps_item_ref (item);
+    mps_item_unref (pending->item);
+    pending->item = item;
+  } else if (_replace_folded (bridge, item)) {
+    /* Folded into another card, nothing to show */
+  } else if (g_hash_table_lookup (priv->filtered, item->uuid)) {
+    /* It may not be muted any more */
+    g_hash_table_remove (priv->filtered, item->uuid);
+    _insert_item (bridge, item, FALSE);
+  } else if (mps_item_index_lookup (priv->index, item->uuid)) {
+    if (priv->unconfirmed_uuids)
+      g_hash_table_remove (priv->unconfirmed_uuids, item->uuid);
+
+    if (mps_filter_matches (item))
+    {
+      _remove_item (bridge, item->uuid);
+      _insert_item (bridge, item, FALSE);
+    } else {
+      _update_item (bridge, item);
+    }
+  } else if (mps_item_index_lookup (priv->archive, item->uuid)) {
+    mps_item_index_update (priv->archive, item);
+    _queue_save_snapshot (bridge);
+  }
+}
+
+static void
+_drop_item (MpsViewBridge *bridge,
+            const gchar   *uuid)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *link;
+
+  if (priv->unconfirmed_uuids)
+    g_hash_table_remove (priv->unconfirmed_uuids, uuid);
+
+  if (mps_item_index_remove (priv->archive, uuid) >= 0)
+    _queue_save_snapshot (bridge);
+
+  if (g_hash_table_remove (priv->filtered, uuid))
+    return;
+
+  link = _find_pending (bridge, uuid);
+
+  if (link)
+  {
+    _pending_item_free ((MpsPendingItem *)link->data);
+    priv->pending = g_list_delete_link (priv->pending, link);
+    priv->n_pending--;
+    g_object_notify (G_OBJECT (bridge), "queue-depth");
+  } else {
+    _remove_item (bridge, uuid);
+  }
+}
+
+static void
+_mute_item (MpsViewBridge *bridge,
+            MpsItem       *item)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  g_hash_table_insert (priv->filtered,
+                       g_strdup (item->uuid),
+                       mps_item_ref (item));
+  _remove_item (bridge, item->uuid);
+}
+
+/* Hide whatever the new rules mute and bring back what they no longer do */
+static void
+_filter_changed_cb (gpointer userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *unmuted = NULL, *muted = NULL, *items, *l;
+  GHashTableIter iter;
+  gpointer item, group;
+  gint i;
+
+  g_hash_table_iter_init (&iter, priv->filtered);
+  while (g_hash_table_iter_next (&iter, NULL, &item))
+    unmuted = g_list_prepend (unmuted, mps_item_ref ((MpsItem *)item));
+
+  g_hash_table_remove_all (priv->filtered);
+
+  items = mps_item_index_get_items (priv->index);
+
+  for (l = items; l; l = l->next)
+  {
+    if (mps_filter_matches ((MpsItem *)l->data))
+      muted = g_list_prepend (muted, mps_item_ref ((MpsItem *)l->data));
+  }
+
+  g_list_free (items);
+
+  /* Folded copies and hidden items may be by a muted author even if the
+   * card isn't, expanded ones were covered with the index
+   */
+  g_hash_table_iter_init (&iter, priv->groups);
+  while (g_hash_table_iter_next (&iter, NULL, &group))
+  {
+    for (l = ((MpsItemGroup *)group)->duplicates; l; l = l->next)
+    {
+      if (mps_filter_matches ((MpsItem *)l->data))
+        muted = g_list_prepend (muted, mps_item_ref ((MpsItem *)l->data));
+    }
+
+    if (((MpsItemGroup *)group)->expanded)
+      continue;
+
+    for (i = 0; i < N_HIDDEN; i++)
+    {
+      for (l = ((MpsItemGroup *)group)->hidden[i]; l; l = l->next)
+      {
+        if (mps_filter_matches ((MpsItem *)l->data))
+          muted = g_list_prepend (muted, mps_item_ref ((MpsItem *)l->data));
+      }
+    }
+  }
+
+  g_debug (G_STRLOC ": Rules changed, muting %d items and rechecking %d",
+           g_list_length (muted),
+           g_list_length (unmuted));
+
+  for (l = muted; l; l = l->next)
+  {
+    _mute_item (bridge, (MpsItem *)l->data);
+    mps_item_unref ((MpsItem *)l->data);
+  }
+
+  /* Anything still muted just goes back in the table */
+  for (l = unmuted; l; l = l->next)
+  {
+    if (_is_outside_retention (bridge, (MpsItem *)l->data))
+      _archive_item (bridge, (MpsItem *)l->data);
+    else
+      _insert_item (bridge, (MpsItem *)l->data, FALSE);
+
+    mps_item_unref ((MpsItem *)l->data);
+  }
+
+  g_list_free (muted);
+  g_list_free (unmuted);
+
+  _apply_retention (bridge);
+}
+
+static void
+_view_items_added_cb (SwClientItemView *view,
+                      GList            *items,
+                      MpsViewBridge    *bridge)
+{
+  GList *sorted = NULL, *l;
+
+  g_debug (G_STRLOC ": %s called", G_STRFUNC);
+
+  /* Copy out the fields we show rather than holding on to the SwItems */
+  for (l = items; l; l = l->next)
+    sorted = g_list_prepend (sorted, mps_item_new_from_sw_item (l->data));
+
+  /* Oldest first, then reversed to newest first */
+  sorted = g_list_sort (sorted, (GCompareFunc)_item_sort_compare_func);
+
+  _add_items (bridge, g_list_reverse (sorted), THRESHOLD, TRUE);
+}
+
+static void
+_view_items_removed_cb (SwClientItemView *view,
+                        GList            *items,
+                        MpsViewBridge    *bridge)
+{
+  GList *l;
+
+  for (l = items; l; l = l->next)
+    _drop_item (bridge, ((SwItem *)l->data)->uuid);
+}
+
+static void
+_view_items_changed_cb (SwClientItemView *view,
+                        GList            *items,
+                        MpsViewBridge    *bridge)
+{
+  GList *l;
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item;
+
+    item = mps_item_new_from_sw_item ((SwItem *)l->data);
+    _change_item (bridge, item);
+    mps_item_unref (item);
+  }
+}
+
+/* Called when the view is replaced, e.g. libsocialweb restarted. The cards
+ * stay put until the new view has had a chance to say what it has.
+ */
+static void
+_detach_view (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *items, *l;
+
+  g_signal_handlers_disconnect_by_func (priv->view,
+                                        _view_items_added_cb,
+                                        bridge);
+  g_signal_handlers_disconnect_by_func (priv->view,
+                                        _view_items_removed_cb,
+                                        bridge);
+  g_signal_handlers_disconnect_by_func (priv->view,
+                                        _view_items_changed_cb,
+                                        bridge);
+  g_object_unref (priv->view);
+  priv->view = NULL;
+
+  /* The new view will deliver anything still wanted again */
+  if (priv->ingest_id != 0)
+  {
+    g_source_remove (priv->ingest_id);
+    priv->ingest_id = 0;
+  }
+
+  g_list_foreach (priv->pending, (GFunc)_pending_item_free, NULL);
+  g_list_free (priv->pending);
+  priv->pending = NULL;
+  priv->n_pending = 0;
+  g_object_notify (G_OBJECT (bridge), "queue-depth");
+
+  if (!priv->unconfirmed_uuids)
+  {
+    priv->unconfirmed_uuids = g_hash_table_new_full (g_str_hash,
+                                                     g_str_equal,
+                                                     g_free,
+                                                     NULL);
+  }
+
+  items = mps_item_index_get_items (priv->index);
+
+  for (l = items; l; l = l->next)
+  {
+    g_hash_table_insert (priv->unconfirmed_uuids,
+                         g_strdup (((MpsItem *)l->data)->uuid),
+                         NULL);
+  }
+
+  g_list_free (items);
+
+  /* An empty view never emits anything so don't wait for it to */
+  if (priv->reconcile_id != 0)
+    g_source_remove (priv->reconcile_id);
+
+  priv->reconcile_id = g_timeout_add_seconds (RECONCILE_GRACE_TIME,
+                                              _reconcile_cb,
+                                              bridge);
+}
+
+void
+mps_view_bridge_set_view (MpsViewBridge    *bridge,
+                          SwClientItemView *view)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->view)
+    _detach_view (bridge);
+
+  priv->view = g_object_ref (view);
+
+  g_signal_connect (priv->view,
+                    "items-added",
+                    (GCallback)_view_items_added_cb,
+                    bridge);
+  g_signal_connect (priv->view,
+                    "items-removed",
+                    (GCallback)_view_items_removed_cb,
+                    bridge);
+  g_signal_connect (priv->view,
+                    "items-changed",
+                    (GCallback)_view_items_changed_cb,
+                    bridge);
+
+  sw_client_item_view_start (priv->view);
+}
+
+static void
+_source_item_added_cb (MpsViewBridge *source,
+                       MpsItem       *item,
+                       MpsViewBridge *bridge)
+{
+  _add_items (bridge, g_list_prepend (NULL, mps_item_ref (item)), 1, FALSE);
+}
+
+static void
+_source_item_changed_cb (MpsViewBridge *source,
+                         MpsItem       *item,
+                         MpsViewBridge *bridge)
+{
+  _change_item (bridge, item);
+}
+
+static void
+_source_item_removed_cb (MpsViewBridge *source,
+                         const gchar   *uuid,
+                         MpsViewBridge *bridge)
+{
+  _drop_item (bridge, uuid);
+}
+
+/* Follow what another bridge has, e.g. to show several feeds as one. The
+ * items themselves are shared with the source.
+ */
+void
+mps_view_bridge_add_source (MpsViewBridge *bridge,
+                            MpsViewBridge *source)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsViewBridgePrivate *source_priv = GET_PRIVATE (source);
+  GList *items;
+
+  if (g_list_find (priv->sources, source))
+    return;
+
+  priv->sources = g_list_prepend (priv->sources, g_object_ref (source));
+
+  g_signal_connect (source,
+                    "item-added",
+                    (GCallback)_source_item_added_cb,
+                    bridge);
+  g_signal_connect (source,
+                    "item-changed",
+                    (GCallback)_source_item_changed_cb,
+                    bridge);
+  g_signal_connect (source,
+                    "item-removed",
+                    (GCallback)_source_item_removed_cb,
+                    bridge);
+
+  /* Already newest first so this just merges into the queue */
+  items = mps_item_index_get_items (source_priv->index);
+  g_list_foreach (items, (GFunc)mps_item_ref, NULL);
+  _add_items (bridge, items, 0, FALSE);
+}
+
+void
+mps_view_bridge_remove_source (MpsViewBridge *bridge,
+                               MpsViewBridge *source)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsViewBridgePrivate *source_priv = GET_PRIVATE (source);
+  GList *items, *l;
+
+  if (!g_list_find (priv->sources, source))
+    return;
+
+  g_signal_handlers_disconnect_by_func (source,
+                                        _source_item_added_cb,
+                                        bridge);
+  g_signal_handlers_disconnect_by_func (source,
+                                        _source_item_changed_cb,
+                                        bridge);
+  g_signal_handlers_disconnect_by_func (source,
+                                        _source_item_removed_cb,
+                                        bridge);
+
+  /* Everything we got from it is still in its index */
+  items = mps_item_index_get_items (source_priv->index);
+
+  for (l = items; l; l = l->next)
+    _drop_item (bridge, ((MpsItem *)l->data)->uuid);
+
+  g_list_free (items);
+
+  priv->sources = g_list_remove (priv->sources, source);
+  g_object_unref (source);
+}
+
+static ClutterActor *
+_feed_box_factory_func (MpsFeedBox *box,
+                        MpsItem    *item,
+                        gpointer    userdata)
+{
+  MpsViewBridge *bridge = MPS_VIEW_BRIDGE (userdata);
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->func)
+    return priv->func (bridge, item, priv->userdata);
+
+  return g_object_new (MPS_TYPE_TWEET_CARD,
+                       "item", item,
+                       NULL);
+}
+
+void
+mps_view_bridge_set_factory_func (MpsViewBridge            *bridge,
+                                  MpsViewBridgeFactoryFunc  func,
+                                  gpointer                  userdata)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  priv->func = func;
+  priv->userdata = userdata;
+}
+
+void
+mps_view_bridge_set_container (MpsViewBridge *bridge,
+                               MpsFeedBox    *container)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  /* Can only be called once */
+  g_assert (!priv->container);
+  priv->container = g_object_ref (container);
+
+  mps_feed_box_set_factory_func (priv->container,
+                                 _feed_box_factory_func,
+                                 bridge);
+
+  /* Changes while hidden just get recorded */
+  g_signal_connect (priv->container,
+                    "notify::mapped",
+                    (GCallback)_container_mapped_notify_cb,
+                    bridge);
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (priv->container))
+    _start_journal (bridge);
+}
+
+void
+mps_view_bridge_set_max_items (MpsViewBridge *bridge,
+                               guint          max_items)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->max_items == max_items)
+    return;
+
+  priv->max_items = max_items;
+  _apply_retention (bridge);
+
+  g_object_notify (G_OBJECT (bridge), "max-items");
+}
+
+void
+mps_view_bridge_set_max_age (MpsViewBridge *bridge,
+                             guint          max_age)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->max_age == max_age)
+    return;
+
+  priv->max_age = max_age;
+  _apply_retention (bridge);
+
+  g_object_notify (G_OBJECT (bridge), "max-age");
+}
+
+/* Only affects posts from now on, cards already folded stay that way */
+void
+mps_view_bridge_set_burst_window (MpsViewBridge *bridge,
+                                  guint          burst_window)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->burst_window == burst_window)
+    return;
+
+  priv->burst_window = burst_window;
+
+  g_object_notify (G_OBJECT (bridge), "burst-window");
+}
+
+void
+mps_view_bridge_set_burst_threshold (MpsViewBridge *bridge,
+                                     guint          burst_threshold)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  if (priv->burst_threshold == burst_threshold)
+    return;
+
+  priv->burst_threshold = burst_threshold;
+
+  g_object_notify (G_OBJECT (bridge), "burst-threshold");
+}
+
+/* Show what was there last time straight away and keep it up to date from
+ * then on. The container must have been set already.
+ */
+void
+mps_view_bridge_set_snapshot_path (MpsViewBridge *bridge,
+                                   const gchar   *path)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *items, *l;
+
+  g_return_if_fail (priv->container);
+
+  /* Can only be called once */
+  g_assert (!priv->snapshot_path);
+  priv->snapshot_path = g_strdup (path);
+
+  items = mps_feed_snapshot_load (path);
+
+  if (items)
+  {
+    priv->unconfirmed_uuids = g_hash_table_new_full (g_str_hash,
+                                                  g_str_equal,
+                                                  g_free,
+                                                  NULL);
+  }
+
+  for (l = items; l; l = l->next)
+  {
+    MpsItem *item = (MpsItem *)l->data;
+
+    if (mps_item_index_lookup (priv->index, item->uuid))
+      continue;
+
+    if (_is_outside_retention (bridge, item))
+    {
+      mps_item_index_insert (priv->archive, item);
+      continue;
+    }
+
+    _insert_item (bridge, item, FALSE);
+    g_hash_table_insert (priv->unconfirmed_uuids, g_strdup (item->uuid), NULL);
+  }
+
+  g_list_foreach (items, (GFunc)mps_item_unref, NULL);
+  g_list_free (items);
+}
+
+SwClientItemView *
+mps_view_bridge_get_view (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  return priv->view;
+}
+
+MpsFeedBox *
+mps_view_bridge_get_container (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  return priv->container;
+}
+
+guint
+mps_view_bridge_get_queue_depth (MpsViewBridge *bridge)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+
+  return priv->n_pending;
+}
+
+/* Bring back archived items, newest first, until n_items new rows are
+ * showing below what is there. Copies, replies, bursts and muted items add
+ * no row so more may be pulled in than that. Returns how many rows were
+ * added, 0 once there is nothing older to show.
+ */
+guint
+mps_view_bridge_load_older (MpsViewBridge *bridge,
+                            guint          n_items)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  GList *items, *l;
+  guint n_shown, count = 0, loaded = 0;
+
+  items = mps_item_index_get_items (priv->archive);
+  n_shown = mps_item_index_get_n_items (priv->index);
+
+  for (l = items; l && count < n_items; l = l->next)
+  {
+    MpsItem *item = mps_item_ref ((MpsItem *)l->data);
+
+    mps_item_index_remove (priv->archive, item->uuid);
+
+    /* Older than everything shown so these go in below the visible rows */
+    _insert_item (bridge, item, FALSE);
+    mps_item_unref (item);
+    loaded++;
+
+    count = MAX ((gint)mps_item_index_get_n_items (priv->index) - (gint)n_shown,
+                 0);
+  }
+
+  g_list_free (items);
+
+  if (loaded > 0)
+  {
+    priv->paged = TRUE;
+
+    g_debug (G_STRLOC ": Loaded %d older items into %d rows, %d left",
+             loaded,
+             count,
+             mps_item_index_get_n_items (priv->archive));
+  }
+
+  return count;
+}
+
+/* Show or hide the rest of the conversation and any burst from the author
+ * under the card for uuid
+ */
+void
+mps_view_bridge_set_thread_expanded (MpsViewBridge *bridge,
+                                     const gchar   *uuid,
+                                     gboolean       expanded)
+{
+  MpsViewBridgePrivate *priv = GET_PRIVATE (bridge);
+  MpsItemGroup *group;
+  gint i;
+
+  g_return_if_fail (MPS_IS_VIEW_BRIDGE (bridge));
+
+  group = g_hash_table_lookup (priv->groups, uuid);
+
+  if (!group || !_group_has_hidden (group) || group->expanded == expanded)
+    return;
+
+  group->expanded = expanded;
+
+  /* The rows for a burst are only made once somebody asks for them */
+  for (i = 0; i < N_HIDDEN; i++)
+  {
+    if (expanded)
+      _show_hidden (bridge, group->hidden[i]);
+    else
+      _hide_hidden (bridge, group->hidden[i]);
+  }
+
+  _container_set_group_state (bridge, group);
+}
@@ -24,6 +24,8 @@
 #include <clutter/clutter.h>
 #include <libsocialweb-client/sw-client.h>
 
+#include "mps-feed-box.h"
+
 G_BEGIN_DECLS
 
 #define MPS_TYPE_VIEW_BRIDGE mps_view_bridge_get_type()
@@ -56,16 +58,36 @@ GType mps_view_bridge_get_type (void);
 MpsViewBridge *mps_view_bridge_new (void);
 void mps_view_bridge_set_view (MpsViewBridge    *bridge,
                                SwClientItemView *view);
-void mps_view_bridge_set_container (MpsViewBridge    *bridge,
-                                    ClutterContainer *container);
+void mps_view_bridge_set_container (MpsViewBridge *bridge,
+                                    MpsFeedBox    *container);
 typedef ClutterActor *(*MpsViewBridgeFactoryFunc) (MpsViewBridge *bridge,
-                                          SwItem        *item,
+                                          MpsItem       *item,
                                           gpointer       userdata);
 void mps_view_bridge_set_factory_func (MpsViewBridge            *bridge,
                                        MpsViewBridgeFactoryFunc  func,
                                        gpointer                  userdata);
+void mps_view_bridge_set_max_items (MpsViewBridge *bridge,
+                                    guint          max_items);
+void mps_view_bridge_set_max_age (MpsViewBridge *bridge,
+                                  guint          max_age);
+void mps_view_bridge_set_burst_window (MpsViewBridge *bridge,
+                                       guint          burst_window);
+void mps_view_bridge_set_burst_threshold (MpsViewBridge *bridge,
+                                          guint          burst_threshold);
+void mps_view_bridge_set_snapshot_path (MpsViewBridge *bridge,
+                                        const gchar   *path);
+void mps_view_bridge_add_source (MpsViewBridge *bridge,
+                                 MpsViewBridge *source);
+void mps_view_bridge_remove_source (MpsViewBridge *bridge,
+                                    MpsViewBridge *source);
 SwClientItemView *mps_view_bridge_get_view (MpsViewBridge *bridge);
-ClutterContainer *mps_view_bridge_get_container (MpsViewBridge *bridge);
+MpsFeedBox *mps_view_bridge_get_container (MpsViewBridge *bridge);
+guint mps_view_bridge_get_queue_depth (MpsViewBridge *bridge);
+guint mps_view_bridge_load_older (MpsViewBridge *bridge,
+                                  guint          n_items);
+void mps_view_bridge_set_thread_expanded (MpsViewBridge *bridge,
+                                          const gchar   *uuid,
+                                          gboolean       expanded);
 
 G_END_DECLS
 
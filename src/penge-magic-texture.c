@@ -24,9 +24,25 @@
 
 G_DEFINE_TYPE (PengeMagicTexture, penge_magic_texture, CLUTTER_TYPE_TEXTURE)
 
+#define GET_PRIVATE_REAL(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), PENGE_TYPE_MAGIC_TEXTURE, PengeMagicTexturePrivate))
+#define GET_PRIVATE(o) ((PengeMagicTexture *)o)->priv
+
+struct _PengeMagicTexturePrivate {
+  /* Part of a larger texture, such as an atlas, to show instead of all of
+   * it. In texels.
+   */
+  gboolean has_region;
+  gint region_x;
+  gint region_y;
+  gint region_width;
+  gint region_height;
+};
+
 static void
 penge_magic_texture_paint (ClutterActor *actor)
 {
+  PengeMagicTexturePrivate *priv = GET_PRIVATE (actor);
   ClutterActorBox box;
   CoglHandle *material, *tex;
   float bw, bh;
@@ -39,14 +55,28 @@ penge_magic_texture_paint (ClutterActor *actor)
   material = clutter_texture_get_cogl_material (CLUTTER_TEXTURE (actor));
   tex = clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (actor));
 
-  bw = (float) cogl_texture_get_width (tex); /* base texture width */
-  bh = (float) cogl_texture_get_height (tex); /* base texture height */
+  if (priv->has_region)
+  {
+    bw = (float) priv->region_width;
+    bh = (float) priv->region_height;
+  } else {
+    bw = (float) cogl_texture_get_width (tex); /* base texture width */
+    bh = (float) cogl_texture_get_height (tex); /* base texture height */
+  }
 
   aw = (float) (box.x2 - box.x1); /* allocation width */
   ah = (float) (box.y2 - box.y1); /* allocation height */
 
-  /* no comment */
-  if ((float)bw/bh < (float)aw/ah)
+  /* Avatars are scaled and cropped to fit when they are decoded so usually
+   * there is nothing to crop.
+   */
+  if (bw * ah == bh * aw)
+  {
+    tx1 = 0;
+    tx2 = 1;
+    ty1 = 0;
+    ty2 = 1;
+  } else if ((float)bw/bh < (float)aw/ah)
   {
     /* fit width */
     v = (((float)ah * bw) / ((float)aw * bh)) / 2;
@@ -63,6 +93,18 @@ penge_magic_texture_paint (ClutterActor *actor)
     ty2 = 1;
   }
 
+  /* Map the crop into the region of the whole texture */
+  if (priv->has_region)
+  {
+    float tw = (float) cogl_texture_get_width (tex);
+    float th = (float) cogl_texture_get_height (tex);
+
+    tx1 = (priv->region_x + tx1 * bw) / tw;
+    tx2 = (priv->region_x + tx2 * bw) / tw;
+    ty1 = (priv->region_y + ty1 * bh) / th;
+    ty2 = (priv->region_y + ty2 * bh) / th;
+  }
+
   alpha = clutter_actor_get_paint_opacity (actor);
 
   cogl_material_set_color4ub (material,
@@ -83,11 +125,33 @@ penge_magic_texture_class_init (PengeMagicTextureClass *klass)
 {
   ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
 
+  g_type_class_add_private (klass, sizeof (PengeMagicTexturePrivate));
+
   actor_class->paint = penge_magic_texture_paint;
 }
 
 static void
 penge_magic_texture_init (PengeMagicTexture *self)
 {
+  self->priv = GET_PRIVATE_REAL (self);
+}
+
+/* Only paint the given region of the texture, for textures in an atlas */
+void
+penge_magic_texture_set_sub_region (PengeMagicTexture *texture,
+                                    gint               x,
+                                    gint               y,
+                                    gint               width,
+                                    gint               height)
+{
+  PengeMagicTexturePrivate *priv = GET_PRIVATE (texture);
+
+  priv->has_region = TRUE;
+  priv->region_x = x;
+  priv->region_y = y;
+  priv->region_width = width;
+  priv->region_height = height;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (texture));
 }
 
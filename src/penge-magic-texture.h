@@ -43,8 +43,11 @@ G_BEGIN_DECLS
 #define PENGE_MAGIC_TEXTURE_GET_CLASS(obj) \
   (G_TYPE_INSTANCE_GET_CLASS ((obj), PENGE_TYPE_MAGIC_TEXTURE, PengeMagicTextureClass))
 
+typedef struct _PengeMagicTexturePrivate PengeMagicTexturePrivate;
+
 typedef struct {
   ClutterTexture parent;
+  PengeMagicTexturePrivate *priv;
 } PengeMagicTexture;
 
 typedef struct {
@@ -53,6 +56,12 @@ typedef struct {
 
 GType penge_magic_texture_get_type (void);
 
+void penge_magic_texture_set_sub_region (PengeMagicTexture *texture,
+                                         gint               x,
+                                         gint               y,
+                                         gint               width,
+                                         gint               height);
+
 G_END_DECLS
 
 #endif /* _PENGE_MAGIC_TEXTURE */